@@ -7,31 +7,560 @@
 #include <AvgEngine/Base/Camera.h>
 #include <algorithm>
 
+using AvgEngine::Render::Rect;
+using AvgEngine::Render::Vertex;
+using AvgEngine::Render::SpriteInstance;
+
+namespace
+{
+	struct bounds
+	{
+		float x0, y0, x1, y1;
+	};
+
+	bounds boundsOf(const Vertex* vertices, size_t count)
+	{
+		bounds b = { vertices[0].x, vertices[0].y, vertices[0].x, vertices[0].y };
+		for (size_t i = 1; i < count; i++)
+		{
+			b.x0 = std::min(b.x0, vertices[i].x);
+			b.y0 = std::min(b.y0, vertices[i].y);
+			b.x1 = std::max(b.x1, vertices[i].x);
+			b.y1 = std::max(b.y1, vertices[i].y);
+		}
+		return b;
+	}
+
+	enum class overlap { Inside, Outside, Partial };
+
+	overlap classify(const bounds& b, const Rect& clip)
+	{
+		if (b.x1 <= clip.x || b.x0 >= clip.x + clip.w || b.y1 <= clip.y || b.y0 >= clip.y + clip.h)
+			return overlap::Outside;
+		if (b.x0 >= clip.x && b.x1 <= clip.x + clip.w && b.y0 >= clip.y && b.y1 <= clip.y + clip.h)
+			return overlap::Inside;
+		return overlap::Partial;
+	}
+
+	uint32_t lerpColour(uint32_t a, uint32_t b, float t)
+	{
+		if (a == b)
+			return a;
+		uint32_t out = 0;
+		for (int shift = 0; shift < 32; shift += 8)
+		{
+			float ca = static_cast<float>((a >> shift) & 0xFF);
+			float cb = static_cast<float>((b >> shift) & 0xFF);
+			out |= static_cast<uint32_t>(ca + (cb - ca) * t + 0.5f) << shift;
+		}
+		return out;
+	}
+
+	Vertex lerpVertex(const Vertex& a, const Vertex& b, float t)
+	{
+		return Vertex(a.x + (b.x - a.x) * t, a.y + (b.y - a.y) * t, a.u + (b.u - a.u) * t, a.v + (b.v - a.v) * t, lerpColour(a.colour, b.colour, t));
+	}
+
+	/**
+	 * \brief Cuts a quad to a clip, if it's axis aligned (uvs and colours are interpolated across the corners, so it looks the same where it's kept)
+	 * \param corners The quad's four vertices, in any order
+	 * \return If it was cut (false if it isn't axis aligned)
+	 */
+	bool clipQuad(Vertex* corners[4], const bounds& b, const Rect& clip)
+	{
+		// find which vertex is which corner (tl, tr, bl, br)
+		const Vertex* at[4] = {};
+		for (int i = 0; i < 4; i++)
+		{
+			bool right = std::abs(corners[i]->x - b.x1) < 0.001f;
+			bool bottom = std::abs(corners[i]->y - b.y1) < 0.001f;
+			if (!right && std::abs(corners[i]->x - b.x0) >= 0.001f)
+				return false;
+			if (!bottom && std::abs(corners[i]->y - b.y0) >= 0.001f)
+				return false;
+			int corner = (bottom ? 2 : 0) + (right ? 1 : 0);
+			if (at[corner] != NULL)
+				return false;
+			at[corner] = corners[i];
+		}
+
+		float w = b.x1 - b.x0;
+		float h = b.y1 - b.y0;
+		Vertex cut[4];
+		for (int i = 0; i < 4; i++)
+		{
+			float x = std::clamp(corners[i]->x, clip.x, clip.x + clip.w);
+			float y = std::clamp(corners[i]->y, clip.y, clip.y + clip.h);
+			float tx = w > 0 ? (x - b.x0) / w : 0;
+			float ty = h > 0 ? (y - b.y0) / h : 0;
+			cut[i] = lerpVertex(lerpVertex(*at[0], *at[1], tx), lerpVertex(*at[2], *at[3], tx), ty);
+			cut[i].x = x;
+			cut[i].y = y;
+		}
+		for (int i = 0; i < 4; i++)
+			*corners[i] = cut[i];
+		return true;
+	}
+
+	enum class clipResult { Kept, Dropped, Cut, Scissor };
+
+	/**
+	 * \brief Cuts a sprite instance to a clip (unrotated ones only, it gets the scale and centering baked in)
+	 */
+	clipResult clipInstance(SpriteInstance& instance, const Rect& clip)
+	{
+		// same as instanced_shader_vert
+		float w = instance.dstW * instance.scale;
+		float h = instance.dstH * instance.scale;
+		float x = instance.dstX;
+		float y = instance.dstY;
+		if (instance.center > 0.5f)
+		{
+			x += (instance.dstW - w) / 2;
+			y += (instance.dstH - h) / 2;
+		}
+
+		bounds b = { x, y, x + w, y + h };
+		if (instance.angle != 0)
+		{
+			float s = std::sin(instance.angle * (3.14159265f / 180));
+			float c = std::cos(instance.angle * (3.14159265f / 180));
+			float hw = (std::abs(w * c) + std::abs(h * s)) / 2;
+			float hh = (std::abs(w * s) + std::abs(h * c)) / 2;
+			float cx = x + w / 2;
+			float cy = y + h / 2;
+			b = { cx - hw, cy - hh, cx + hw, cy + hh };
+		}
+
+		overlap o = classify(b, clip);
+		if (o != overlap::Partial)
+			return o == overlap::Inside ? clipResult::Kept : clipResult::Dropped;
+		if (instance.angle != 0)
+			return clipResult::Scissor;
+
+		float x0 = std::max(x, clip.x);
+		float y0 = std::max(y, clip.y);
+		float x1 = std::min(x + w, clip.x + clip.w);
+		float y1 = std::min(y + h, clip.y + clip.h);
+		instance.srcX += (x0 - x) / w * instance.srcW;
+		instance.srcY += (y0 - y) / h * instance.srcH;
+		instance.srcW *= (x1 - x0) / w;
+		instance.srcH *= (y1 - y0) / h;
+		instance.dstX = x0;
+		instance.dstY = y0;
+		instance.dstW = x1 - x0;
+		instance.dstH = y1 - y0;
+		instance.scale = 1;
+		instance.center = 0;
+		return clipResult::Cut;
+	}
+
+	bool sameVertex(const Vertex& a, const Vertex& b)
+	{
+		return a.x == b.x && a.y == b.y && a.u == b.u && a.v == b.v && a.colour == b.colour;
+	}
+}
+
 void AvgEngine::Base::Camera::draw()
 {
 	// Viewport width and height
 	glViewport(0, 0, w, h);
 
-	std::sort(drawCalls.begin(), drawCalls.end(), drawCall());
+	stats = {};
+	stats.objectsDrawn = drawnObjects;
+	stats.objectsCulled = culledObjects;
+	drawnObjects = 0;
+	culledObjects = 0;
+
+	// Cut clipped vertices to their clips, so they can be drawn with everything else
+	applyClips();
+
+	// Sort the buckets we used this frame by zIndex, then state, then the order they were added in
+	sortActiveCalls();
+
+	if (singleUpload)
+		drawSingleUpload();
+	else
+		drawPerCall();
+
+	// Empty the buckets but keep their storage around for next frame
+	for (size_t index : activeCalls)
+	{
+		drawCalls[index].vertices.clear();
+		drawCalls[index].instances.clear();
+		drawCalls[index].clipSpans.clear();
+	}
+
+	activeCalls.clear();
+
+	// Every so often, get rid of buckets that haven't been used in a while
+	frame++;
+	if (frame % std::max(bucketLifetime, 1) == 0)
+		pruneDrawCalls();
+}
+
+void AvgEngine::Base::Camera::applyClips()
+{
+	// scissored buckets made along the way get added to activeCalls, but they have nothing to cut
+	size_t active = activeCalls.size();
+	for (size_t a = 0; a < active; a++)
+	{
+		size_t index = activeCalls[a];
+		if (drawCalls[index].clipSpans.empty())
+			continue;
+
+		drawCall& call = drawCalls[index];
+		scissorSpans.clear();
+		scissorVertices.clear();
+		scissorInstances.clear();
+
+		// what doesn't get cut goes to a scissored bucket, grouped by its clip
+		auto toScissor = [&](const Rect& clip, size_t start) {
+			if (scissorSpans.empty() || scissorSpans.back().clip != clip)
+				scissorSpans.push_back({ start, clip });
+			stats.scissored++;
+		};
+
+		size_t count = call.instanced ? call.instances.size() : call.vertices.size();
+		size_t write = 0;
+		for (size_t s = 0; s <= call.clipSpans.size(); s++)
+		{
+			// everything before the first span isn't clipped
+			size_t start = s == 0 ? 0 : call.clipSpans[s - 1].start;
+			size_t end = s < call.clipSpans.size() ? call.clipSpans[s].start : count;
+			Rect clip = s == 0 ? Rect() : call.clipSpans[s - 1].clip;
+			bool clipped = clip != Rect();
+
+			if (call.instanced)
+			{
+				for (size_t i = start; i < end; i++)
+				{
+					SpriteInstance instance = call.instances[i];
+					clipResult result = clipped ? clipInstance(instance, clip) : clipResult::Kept;
+					if (result == clipResult::Dropped)
+						continue;
+					if (result == clipResult::Scissor)
+					{
+						toScissor(clip, scissorInstances.size());
+						scissorInstances.push_back(instance);
+						continue;
+					}
+					if (result == clipResult::Cut)
+						stats.clipped++;
+					call.instances[write++] = instance;
+				}
+				continue;
+			}
+
+			size_t i = start;
+			while (i < end)
+			{
+				// quads are 4 vertices, triangles are 3 (or 6 if they're a rect, from DisplayHelper::RectToVertex)
+				size_t size = call.quads ? 4 : 3;
+				if (!call.quads && i + 6 <= end && sameVertex(call.vertices[i + 3], call.vertices[i + 2]) && sameVertex(call.vertices[i + 4], call.vertices[i + 1]))
+					size = 6;
+				size = std::min(size, end - i);
+
+				Vertex primitive[6];
+				std::copy(call.vertices.begin() + i, call.vertices.begin() + i + size, primitive);
+				i += size;
+
+				if (clipped && size >= 3)
+				{
+					bounds b = boundsOf(primitive, size);
+					overlap o = classify(b, clip);
+					if (o == overlap::Outside)
+						continue;
+					if (o == overlap::Partial)
+					{
+						// tl, bl, tr, br
+						Vertex* corners[4] = { &primitive[0], &primitive[1], &primitive[2], &primitive[size == 6 ? 5 : 3] };
+						if (size != 3 && clipQuad(corners, b, clip))
+						{
+							if (size == 6)
+							{
+								primitive[3] = primitive[2];
+								primitive[4] = primitive[1];
+							}
+							stats.clipped++;
+						}
+						else
+						{
+							toScissor(clip, scissorVertices.size());
+							scissorVertices.insert(scissorVertices.end(), primitive, primitive + size);
+							continue;
+						}
+					}
+				}
+
+				std::copy(primitive, primitive + size, call.vertices.begin() + write);
+				write += size;
+			}
+		}
+
+		if (call.instanced)
+			call.instances.resize(write);
+		else
+			call.vertices.resize(write);
+		call.clipSpans.clear();
 
-	for (drawCall& call : drawCalls)
+		if (scissorSpans.empty())
+			continue;
+
+		// getBucket can move drawCalls around, so copy what the scissored buckets need first
+		drawCall state;
+		state.tag = call.tag;
+		state.zIndex = call.zIndex;
+		state.original = call.original;
+		state.texture = call.texture;
+		state.shad = call.shad;
+		state.quads = call.quads;
+		state.instanced = call.instanced;
+
+		size_t total = state.instanced ? scissorInstances.size() : scissorVertices.size();
+		for (size_t s = 0; s < scissorSpans.size(); s++)
+		{
+			size_t start = scissorSpans[s].start;
+			size_t end = s + 1 < scissorSpans.size() ? scissorSpans[s + 1].start : total;
+			state.clip = scissorSpans[s].clip;
+			drawCall& bucket = getBucket(state, true);
+			if (state.instanced)
+				bucket.instances.insert(bucket.instances.end(), scissorInstances.begin() + start, scissorInstances.begin() + end);
+			else
+				bucket.vertices.insert(bucket.vertices.end(), scissorVertices.begin() + start, scissorVertices.begin() + end);
+		}
+	}
+}
+
+void AvgEngine::Base::Camera::sortActiveCalls()
+{
+	size_t count = activeCalls.size();
+	if (count < 2)
+		return;
+
+	sortKeys.resize(count);
+	sortKeysScratch.resize(count);
+	sortScratch.resize(count);
+	sortClips.clear();
+
+	uint64_t same = ~0ull;
+	uint64_t first = 0;
+	for (size_t i = 0; i < count; i++)
+	{
+		const drawCall& call = drawCalls[activeCalls[i]];
+
+		// clips get small ids in the order they show up (there's usually only a handful)
+		uint64_t clipId = 0;
+		if (batchSort && call.clip != Render::Rect())
+		{
+			auto it = std::find(sortClips.begin(), sortClips.end(), call.clip);
+			if (it == sortClips.end())
+			{
+				sortClips.push_back(call.clip);
+				it = sortClips.end() - 1;
+			}
+			clipId = std::min<uint64_t>(static_cast<uint64_t>(it - sortClips.begin()) + 1, 0xFF);
+		}
+
+		uint64_t key = sortKey(call, clipId, i);
+		if (i == 0)
+			first = key;
+		// track which bits differ between keys, so digits that are the same everywhere get skipped
+		same &= ~(key ^ first);
+		sortKeys[i] = key;
+	}
+
+	uint64_t* keys = sortKeys.data();
+	uint64_t* keysOut = sortKeysScratch.data();
+	size_t* indices = activeCalls.data();
+	size_t* indicesOut = sortScratch.data();
+
+	// 8 passes of 8 bits, least significant first. Each pass is a counting sort, so it's stable.
+	for (int shift = 0; shift < 64; shift += 8)
 	{
+		if (((~same >> shift) & 0xFF) == 0)
+			continue;
+
+		size_t offsets[256] = {};
+		for (size_t i = 0; i < count; i++)
+			offsets[(keys[i] >> shift) & 0xFF]++;
+
+		size_t total = 0;
+		for (size_t& o : offsets)
+		{
+			size_t c = o;
+			o = total;
+			total += c;
+		}
+
+		for (size_t i = 0; i < count; i++)
+		{
+			size_t o = offsets[(keys[i] >> shift) & 0xFF]++;
+			keysOut[o] = keys[i];
+			indicesOut[o] = indices[i];
+		}
+
+		std::swap(keys, keysOut);
+		std::swap(indices, indicesOut);
+	}
+
+	// an odd number of passes leaves the result in the scratch buffer
+	if (indices != activeCalls.data())
+		std::copy(indices, indices + count, activeCalls.data());
+}
+
+void AvgEngine::Base::Camera::drawPerCall()
+{
+	for (size_t index : activeCalls)
+	{
+		drawCall& call = drawCalls[index];
+		if (call.instanced)
+		{
+			if (call.instances.size() == 0)
+				continue;
+			// the state cache skips the scissor calls when consecutive calls share a clip
+			Render::Display::Clip(call.clip != Render::Rect() ? &call.clip : NULL);
+			call.shad->GL_Use();
+			call.texture->Bind();
+			Render::Display::DrawInstances(call.instances.data(), call.instances.size());
+
+			stats.uploads++;
+			stats.bytes += sizeof(Render::SpriteInstance) * call.instances.size();
+			stats.drawCalls++;
+			stats.stateChanges += 2;
+			continue;
+		}
+		if (call.vertices.size() == 0)
+			continue;
 		// Clear the buffer so we know nothing is there
 		Render::Display::ClearBuffer();
 		// Set our clip rect (if its not the default one)
-		if (call.clip != Render::Rect())
-		{
-			Render::Display::Clip(&call.clip);
-		}
+		Render::Display::Clip(call.clip != Render::Rect() ? &call.clip : NULL);
 		// Add our call's vertices
 		Render::Display::AddVertex(call.vertices);
 		// Draw all of the vertices
-		Render::Display::DrawBuffer(call.texture, call.shad);
-		// Reset the clip
-		Render::Display::Clip(NULL);
+		Render::Display::DrawBuffer(call.texture, call.shad, call.quads);
+
+		stats.uploads++;
+		stats.bytes += sizeof(Render::Vertex) * call.vertices.size();
+		stats.drawCalls++;
+		stats.stateChanges += 2;
+	}
+	// Reset the clip
+	Render::Display::Clip(NULL);
+}
+
+void AvgEngine::Base::Camera::drawSingleUpload()
+{
+	size_t total = 0;
+	for (size_t index : activeCalls)
+		total += drawCalls[index].vertices.size();
+
+	// Write every call into one range of the streaming buffer, in sorted order
+	GLint first = 0;
+	if (total != 0)
+	{
+		Render::Vertex* mapped = Render::Display::MapStream(total, &first);
+		if (mapped == NULL)
+			return;
+
+		for (size_t index : activeCalls)
+		{
+			std::vector<Render::Vertex>& verts = drawCalls[index].vertices;
+			mapped = std::copy(verts.begin(), verts.end(), mapped);
+		}
+		Render::Display::UnmapStream();
+
+		stats.uploads = 1;
+		stats.bytes = sizeof(Render::Vertex) * total;
+	}
+
+	// Instanced calls use their own VAO, so the batch one gets rebound after them
+	bool batchBound = false;
+
+	OpenGL::Shader* currentShader = NULL;
+	GLuint currentTexture = 0;
+	Render::Rect* currentClip = NULL;
+	bool clipped = false;
+	bool quads = false;
+	bool instanced = false;
 
+	// Ranges that sit next to each other with the same state get merged into one draw
+	GLint rangeStart = first;
+	GLsizei rangeCount = 0;
+
+	auto flush = [&]() {
+		if (rangeCount == 0)
+			return;
+		if (quads)
+			Render::Display::DrawQuads(rangeStart, rangeCount);
+		else
+			glDrawArrays(GL_TRIANGLES, rangeStart, rangeCount);
+		stats.drawCalls++;
+		rangeStart += rangeCount;
+		rangeCount = 0;
+	};
+
+	for (size_t index : activeCalls)
+	{
+		drawCall& call = drawCalls[index];
+		GLsizei count = static_cast<GLsizei>(call.vertices.size());
+		if (call.instanced ? call.instances.size() == 0 : count == 0)
+			continue;
+
+		bool hasClip = call.clip != Render::Rect();
+		bool shaderChanged = call.shad != currentShader;
+		bool textureChanged = call.texture->id != currentTexture;
+		bool clipChanged = hasClip != clipped || (hasClip && *currentClip != call.clip);
+
+		if (shaderChanged || textureChanged || clipChanged || call.quads != quads || call.instanced != instanced)
+		{
+			flush();
+			quads = call.quads;
+			instanced = call.instanced;
+
+			if (shaderChanged)
+			{
+				call.shad->GL_Use();
+				currentShader = call.shad;
+				stats.stateChanges++;
+			}
+			if (textureChanged)
+			{
+				call.texture->Bind();
+				currentTexture = call.texture->id;
+				stats.stateChanges++;
+			}
+			if (clipChanged)
+			{
+				Render::Display::Clip(hasClip ? &call.clip : NULL);
+				currentClip = hasClip ? &call.clip : NULL;
+				clipped = hasClip;
+				stats.stateChanges++;
+			}
+		}
+
+		if (call.instanced)
+		{
+			Render::Display::DrawInstances(call.instances.data(), call.instances.size());
+			stats.uploads++;
+			stats.bytes += sizeof(Render::SpriteInstance) * call.instances.size();
+			stats.drawCalls++;
+			batchBound = false;
+			continue;
+		}
+
+		if (!batchBound)
+		{
+			Render::Display::BindBatch();
+			batchBound = true;
+		}
+
+		rangeCount += count;
 	}
+	flush();
 
-	// Clear all of the draw calls so we don't draw things twice
-	drawCalls.clear();
-}
\ No newline at end of file
+	// Reset the clip
+	if (clipped)
+		Render::Display::Clip(NULL);
+}
@@ -9,6 +9,12 @@
 #define CAMERA_H
 
 #include <vector>
+#include <unordered_map>
+#include <cmath>
+#include <span>
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
 #include <iostream>
 #include <AvgEngine/Render/Display.h>
 #include <AvgEngine/Render/OpenGL/Shader.h>
@@ -17,26 +23,132 @@
 
 namespace AvgEngine::Base
 {
+	/**
+	 * \brief The state that separates one draw call from another (zIndex, texture, shader, and clip)
+	 */
+	struct drawCallKey
+	{
+		int zIndex = 0;
+		GLuint texture = 0;
+		GLuint shader = 0;
+		// clip is stored in thousandths so it lines up with Rect's tolerance
+		int clipX = 0, clipY = 0, clipW = 0, clipH = 0;
+		bool quads = false;
+		bool instanced = false;
+
+		bool operator==(const drawCallKey& other) const = default;
+	};
+
+	struct drawCallKeyHash
+	{
+		size_t operator()(const drawCallKey& k) const
+		{
+			size_t h = std::hash<int>()(k.zIndex);
+			const int parts[] = { static_cast<int>(k.texture), static_cast<int>(k.shader), k.clipX, k.clipY, k.clipW, k.clipH };
+			for (int p : parts)
+				h ^= std::hash<int>()(p) + 0x9e3779b9 + (h << 6) + (h >> 2);
+			return h ^ (k.quads | (k.instanced << 1));
+		}
+	};
+
+	/**
+	 * \brief Where a clip starts in a bucket's vertices (or instances). It lasts until the next span, or the end.
+	 */
+	struct clipSpan
+	{
+		size_t start = 0;
+		Render::Rect clip;
+	};
+
 	struct drawCall
 	{
 		std::string tag = "object";
+		/**
+		 * \brief The order the call draws in (higher is on top), between Camera::minZIndex and Camera::maxZIndex
+		 */
 		int zIndex = 0;
 		Render::Rect original;
+		/**
+		 * \brief For buckets, this is cleared every frame but keeps its capacity, so once a scene has been drawn it stops allocating
+		 */
 		std::vector<Render::Vertex> vertices{};
 		AvgEngine::OpenGL::Texture* texture = NULL;
 		OpenGL::Shader* shad = NULL;
 		AvgEngine::Render::Rect clip;
 
+		/**
+		 * \brief If the vertices are quads (4 per, drawn with the shared index buffer) instead of triangles
+		 */
+		bool quads = false;
+
+		/**
+		 * \brief If this call is made of sprite instances (drawn with Display::instancedShader) instead of vertices
+		 */
+		bool instanced = false;
+		std::vector<Render::SpriteInstance> instances{};
+
+		/**
+		 * \brief The clips of what was added to this bucket, if they get cut on the CPU (see Camera::cpuClip). Empty means nothing is clipped.
+		 */
+		std::vector<clipSpan> clipSpans{};
+
+		/**
+		 * \brief The last frame this call had vertices added to it
+		 */
+		int lastUsed = 0;
+
 		bool operator==(const drawCall& other) {
 			return (zIndex == other.zIndex) &&
 				(texture->id == other.texture->id) &&
-				(shad->program == other.shad->program) && (clip == other.clip);
+				(shad->program == other.shad->program) && (clip == other.clip) && (quads == other.quads) && (instanced == other.instanced);
 		}
 
 		bool operator()(const drawCall& a, const drawCall& b) {
 			return a.zIndex < b.zIndex;
 		}
 
+		/**
+		 * \brief Get the key used to find this call in a camera's bucket index
+		 * \return The draw call key
+		 */
+		drawCallKey key() const
+		{
+			drawCallKey k;
+			k.zIndex = zIndex;
+			k.texture = texture ? texture->id : 0;
+			k.shader = shad ? shad->program : 0;
+			k.clipX = static_cast<int>(std::round(clip.x * 1000));
+			k.clipY = static_cast<int>(std::round(clip.y * 1000));
+			k.clipW = static_cast<int>(std::round(clip.w * 1000));
+			k.clipH = static_cast<int>(std::round(clip.h * 1000));
+			k.quads = quads;
+			k.instanced = instanced;
+			return k;
+		}
+	};
+
+	/**
+	 * \brief Counters for what a camera did during its last draw
+	 */
+	struct frameStats
+	{
+		int uploads = 0;
+		size_t bytes = 0;
+		int drawCalls = 0;
+		int stateChanges = 0;
+		/**
+		 * \brief Quads, triangles, and instances that were cut to their clip on the CPU
+		 */
+		int clipped = 0;
+		/**
+		 * \brief Ones that couldn't be (rotated across a clip's edge), and were drawn with a scissor instead
+		 */
+		int scissored = 0;
+		/**
+		 * \brief Objects that made vertices, and ones that were skipped because they couldn't be seen (see Camera::cull)
+		 */
+		int objectsDrawn = 0;
+		int objectsCulled = 0;
 	};
 
 	/**
@@ -46,7 +158,63 @@ namespace AvgEngine::Base
 	{
 	public:
 		virtual ~Camera() = default;
+
+		/**
+		 * \brief Every draw call bucket this camera knows about. Buckets (and their vertex storage) are kept between frames.
+		 */
 		std::vector<drawCall> drawCalls{};
+		/**
+		 * \brief Maps a draw call's key to its index in drawCalls
+		 */
+		std::unordered_map<drawCallKey, size_t, drawCallKeyHash> drawCallIndex{};
+		/**
+		 * \brief The indices of the buckets that have been used this frame, in the order they were first used
+		 */
+		std::vector<size_t> activeCalls{};
+
+		/**
+		 * \brief How many frames a bucket can go unused before it gets thrown out (anything under 1 counts as 1)
+		 */
+		int bucketLifetime = 120;
+		int frame = 0;
+
+		/**
+		 * \brief If the whole frame should be uploaded at once and drawn in ranges (instead of one upload per draw call)
+		 */
+		bool singleUpload = true;
+
+		/**
+		 * \brief If sprites using the default shader should be drawn with GPU instancing (only used if it's supported)
+		 */
+		bool instancedSprites = false;
+
+		/**
+		 * \brief If calls on the same zIndex should be grouped by shader, texture, and clip (fewer state changes) instead of kept in the order they were first added
+		 */
+		bool batchSort = true;
+
+		/**
+		 * \brief If clipped things should be cut to their clip on the CPU (so differently clipped calls with the same texture still share a draw)
+		 * instead of each clip getting its own draw with a scissor
+		 */
+		bool cpuClip = true;
+
+		/**
+		 * \brief If objects that are off the camera (or outside their clip) should skip making vertices
+		 */
+		bool culling = true;
+
+		/**
+		 * \brief Objects drawn and culled since the last draw (they go into stats when the camera draws)
+		 */
+		int drawnObjects = 0;
+		int culledObjects = 0;
+
+		/**
+		 * \brief The counters from the last time this camera was drawn
+		 */
+		frameStats stats{};
+
 		Camera() = default;
 		int w, h;
 		Camera(int _w, int _h)
@@ -80,6 +248,7 @@ namespace AvgEngine::Base
 		{
 			drawCall call;
 			call.texture = texture;
+			call.shad = shader;
 			call.zIndex = zIndex;
 			call.vertices = vertices;
 			call.clip = {};
@@ -87,6 +256,21 @@ namespace AvgEngine::Base
 			return call;
 		}
 
+		/**
+		 * \brief A helper function to format draw calls made of quads (4 vertices each, see DisplayHelper::RectToQuad)
+		 * \param zIndex The zIndex of the draw call
+		 * \param texture The texture of the draw call
+		 * \param shader The shader of the draw call
+		 * \param vertices The vertices of the draw call
+		 * \return The formatted draw call struct
+		 */
+		static drawCall FormatQuadCall(int zIndex, AvgEngine::OpenGL::Texture* texture, OpenGL::Shader* shader, std::vector<Render::Vertex> vertices, Render::Rect original)
+		{
+			drawCall call = FormatDrawCall(zIndex, texture, shader, vertices, original);
+			call.quads = true;
+			return call;
+		}
+
 		bool checkIfInsideClip(Render::Rect r, Render::Rect clip)
 		{
 			bool checkClipGreater = clip.x > r.x + r.w;
@@ -100,34 +284,254 @@ namespace AvgEngine::Base
 		}
 
 		/**
-		 * \brief Add a draw call (or if it already exists, add on to it)
-		 * \param call The draw call struct to add
+		 * \brief If something could show up on the camera (always true when culling is off)
+		 * \param bounds Where it is, after its transform (see DisplayHelper::QuadBounds)
+		 * \param clip Its clip (an empty rect for none)
 		 */
-		bool addDrawCall(drawCall& call)
+		bool canSee(Render::Rect bounds, Render::Rect clip)
+		{
+			if (!culling)
+				return true;
+
+			float x0 = 0, y0 = 0, x1 = static_cast<float>(w), y1 = static_cast<float>(h);
+			if (clip != Render::Rect())
+			{
+				x0 = std::max(x0, clip.x);
+				y0 = std::max(y0, clip.y);
+				x1 = std::min(x1, clip.x + clip.w);
+				y1 = std::min(y1, clip.y + clip.h);
+			}
+
+			return std::min(bounds.x, bounds.x + bounds.w) < x1 && std::max(bounds.x, bounds.x + bounds.w) > x0
+				&& std::min(bounds.y, bounds.y + bounds.h) < y1 && std::max(bounds.y, bounds.y + bounds.h) > y0;
+		}
+
+		/**
+		 * \brief Checks if an object can be skipped (before it makes any vertices), and counts it as culled or drawn
+		 * \param bounds Where the object is, after its transform (see DisplayHelper::QuadBounds)
+		 * \param clip The object's clip (an empty rect for none)
+		 * \return If the object can't be seen
+		 */
+		bool cull(Render::Rect bounds, Render::Rect clip)
+		{
+			if (canSee(bounds, clip))
+			{
+				drawnObjects++;
+				return false;
+			}
+			culledObjects++;
+			return true;
+		}
+
+		/**
+		 * \brief If a call's clip gets cut on the CPU (instead of the call going in a scissored bucket)
+		 */
+		bool clipsOnCpu(drawCall& call)
+		{
+			return cpuClip && call.clip != Render::Rect();
+		}
+
+		/**
+		 * \brief Finds (or creates) the bucket a draw call belongs in, and marks it as used this frame
+		 * \param call The draw call struct to find a bucket for
+		 * \return The bucket
+		 */
+		drawCall& getBucket(drawCall& call)
+		{
+			return getBucket(call, !clipsOnCpu(call));
+		}
+
+		/**
+		 * \brief Finds (or creates) the bucket a draw call belongs in, and marks it as used this frame
+		 * \param call The draw call struct to find a bucket for
+		 * \param scissor If the call's clip is part of the bucket (drawn with a scissor). If not, the clip is ignored and the bucket is shared with unclipped calls.
+		 * \return The bucket
+		 */
+		drawCall& getBucket(drawCall& call, bool scissor)
 		{
 			if (call.texture == NULL)
 				call.texture = OpenGL::Texture::returnWhiteTexture();
 			if (call.shad == NULL)
-				call.shad = Render::Display::defaultShader;
-
-			// See if we can find a draw call already with the same shader, texture, and zIndex
-			auto it = std::find(drawCalls.begin(), drawCalls.end(), call);
-			if (it != drawCalls.end()) {
-				// We found it, so instead of creating a new draw call lets just append to this one
-				auto index = std::distance(drawCalls.begin(), it);
-				drawCall& modify = drawCalls[index];
-				for (Render::Vertex v : call.vertices)
-					modify.vertices.push_back(v);
+				call.shad = call.instanced ? Render::Display::instancedShader : Render::Display::defaultShader;
+
+			// See if we already have a bucket with the same shader, texture, zIndex, and clip
+			drawCallKey key = call.key();
+			if (!scissor)
+				key.clipX = key.clipY = key.clipW = key.clipH = 0;
+			auto it = drawCallIndex.find(key);
+			if (it == drawCallIndex.end())
+			{
+				// We didn't find it, so make a new bucket for it
+				it = drawCallIndex.emplace(key, drawCalls.size()).first;
+				drawCall bucket;
+				bucket.zIndex = call.zIndex;
+				bucket.clip = scissor ? call.clip : Render::Rect();
+				bucket.quads = call.quads;
+				bucket.instanced = call.instanced;
+				bucket.lastUsed = frame - 1;
+				drawCalls.push_back(bucket);
 			}
-			else // We didn't find it, so we can just push the draw call directly onto the vector
-				drawCalls.push_back(call);
+
+			drawCall& modify = drawCalls[it->second];
+			if (modify.lastUsed != frame)
+			{
+				// First use this frame, the bucket takes this call's info (the pointers could have changed since last time)
+				modify.lastUsed = frame;
+				modify.tag = call.tag;
+				modify.original = call.original;
+				modify.texture = call.texture;
+				modify.shad = call.shad;
+				activeCalls.push_back(it->second);
+			}
+			return modify;
+		}
+
+		/**
+		 * \brief Remembers the clip of what's about to be added to a bucket (at start), if it's different from what was added before
+		 */
+		static void markClip(drawCall& bucket, size_t start, Render::Rect clip)
+		{
+			if (bucket.clipSpans.empty() ? clip == Render::Rect() : bucket.clipSpans.back().clip == clip)
+				return;
+			bucket.clipSpans.push_back({ start, clip });
+		}
+
+		/**
+		 * \brief Add a draw call (or if it already exists, add on to it)
+		 * \param call The draw call struct to add
+		 */
+		bool addDrawCall(drawCall& call)
+		{
+			bool cpu = clipsOnCpu(call);
+			drawCall& bucket = getBucket(call, !cpu);
+			markClip(bucket, bucket.vertices.size(), cpu ? call.clip : Render::Rect());
+			bucket.vertices.insert(bucket.vertices.end(), call.vertices.begin(), call.vertices.end());
 			return true;
 		}
 
+		/**
+		 * \brief Makes room for vertices at the end of the bucket that matches a draw call, so they can be written in place.
+		 * The returned span is only good until the next call to this camera.
+		 * \param call The draw call struct describing the bucket (its vertices are ignored)
+		 * \param count The amount of vertices to make room for
+		 * \return The vertices to write to
+		 */
+		std::span<Render::Vertex> reserveVertices(drawCall& call, size_t count)
+		{
+			bool cpu = clipsOnCpu(call);
+			drawCall& bucket = getBucket(call, !cpu);
+			size_t start = bucket.vertices.size();
+			markClip(bucket, start, cpu ? call.clip : Render::Rect());
+			bucket.vertices.resize(start + count);
+			return std::span<Render::Vertex>(bucket.vertices).subspan(start, count);
+		}
+
+		/**
+		 * \brief Add a sprite instance to the instanced bucket that matches a draw call (its vertices are ignored)
+		 * \param call The draw call struct describing the bucket (zIndex, texture, clip)
+		 * \param instance The instance to add
+		 */
+		bool addInstance(drawCall& call, const Render::SpriteInstance& instance)
+		{
+			call.instanced = true;
+			call.shad = NULL;
+			bool cpu = clipsOnCpu(call);
+			drawCall& bucket = getBucket(call, !cpu);
+			markClip(bucket, bucket.instances.size(), cpu ? call.clip : Render::Rect());
+			bucket.instances.push_back(instance);
+			return true;
+		}
+
+		/**
+		 * \brief Throws out buckets that haven't been used in a while (and rebuilds the index)
+		 */
+		void pruneDrawCalls()
+		{
+			std::vector<drawCall> kept;
+			std::unordered_map<drawCallKey, size_t, drawCallKeyHash> index;
+			kept.reserve(drawCalls.size());
+			index.reserve(drawCallIndex.size());
+			for (auto& [key, i] : drawCallIndex)
+			{
+				if (frame - drawCalls[i].lastUsed > std::max(bucketLifetime, 1))
+					continue;
+				index.emplace(key, kept.size());
+				kept.push_back(std::move(drawCalls[i]));
+			}
+			drawCalls = std::move(kept);
+			drawCallIndex = std::move(index);
+		}
+
 		/**
 		 * \brief Render all of the current draw calls
 		 */
 		virtual void draw();
+
+		/**
+		 * \brief The range of zIndexes the sort key can order (16 bits)
+		 */
+		static constexpr int minZIndex = -32768;
+		static constexpr int maxZIndex = 32767;
+
+		/**
+		 * \brief Packs a call's state into a 64-bit key. From the top: zIndex (16 bits), shader (8), texture (12), clip (8), and sequence (20).
+		 * Shader and texture ids are truncated, which can only cost a state change, never the order of zIndexes or sequences.
+		 * zIndex has to be within minZIndex and maxZIndex, anything past them is clamped (and would draw in the wrong order).
+		 * \param call The draw call to make a key for
+		 * \param clipId The call's clip id (0 for no clip)
+		 * \param sequence The order the call was first added in this frame
+		 * \return The sort key
+		 */
+		uint64_t sortKey(const drawCall& call, uint64_t clipId, uint64_t sequence) const
+		{
+			assert(call.zIndex >= minZIndex && call.zIndex <= maxZIndex && "zIndex doesn't fit in the sort key");
+			uint64_t layer = static_cast<uint64_t>(std::clamp(call.zIndex, minZIndex, maxZIndex) - minZIndex);
+			uint64_t key = layer << 48;
+			if (batchSort)
+			{
+				key |= (static_cast<uint64_t>(call.shad ? call.shad->program : 0) & 0xFF) << 40;
+				key |= (static_cast<uint64_t>(call.texture ? call.texture->id : 0) & 0xFFF) << 28;
+				key |= (clipId & 0xFF) << 20;
+			}
+			return key | (sequence & 0xFFFFF);
+		}
+
+	protected:
+		/**
+		 * \brief Sort keys for activeCalls, and scratch space for the radix sort (kept between frames so sorting doesn't allocate)
+		 */
+		std::vector<uint64_t> sortKeys{};
+		std::vector<uint64_t> sortKeysScratch{};
+		std::vector<size_t> sortScratch{};
+		std::vector<Render::Rect> sortClips{};
+
+		/**
+		 * \brief What applyClips couldn't cut, on its way to scissored buckets (kept between frames so clipping doesn't allocate)
+		 */
+		std::vector<clipSpan> scissorSpans{};
+		std::vector<Render::Vertex> scissorVertices{};
+		std::vector<Render::SpriteInstance> scissorInstances{};
+
+		/**
+		 * \brief Cuts every active bucket's clipped vertices and instances to their clips (dropping what's completely outside).
+		 * Anything rotated across a clip's edge is moved to a scissored bucket instead.
+		 */
+		void applyClips();
+
+		/**
+		 * \brief Sorts activeCalls by their sort keys with a stable LSD radix sort (the calls themselves don't move)
+		 */
+		void sortActiveCalls();
+
+		/**
+		 * \brief Draws every active call with its own upload
+		 */
+		void drawPerCall();
+
+		/**
+		 * \brief Packs every active call into one upload, then draws it in ranges
+		 */
+		void drawSingleUpload();
 	};
 
 	class Primitives
@@ -143,46 +547,27 @@ namespace AvgEngine::Base
 			float _toX2 = toX + thickness;
 			float _toY = toY;
 
-			std::vector<Render::Vertex> vertices;
+			drawCall c = Camera::FormatQuadCall(zIndex, NULL, NULL, {}, AvgEngine::Render::Rect());
+			std::span<Render::Vertex> vertices = camera->reserveVertices(c, 4);
 
-			Render::Vertex tL = Render::Vertex(_x, _y, 0, 0,r,g,b,a);
-			Render::Vertex tR = Render::Vertex(_x2, _y, 1, 0, r, g, b, a);
-			Render::Vertex bL = Render::Vertex(_toX, _toY, 0, 1, r, g, b, a);
-			Render::Vertex bR = Render::Vertex(_toX2, _toY, 1, 1, r, g, b, a);
-
-
-			vertices.push_back(tL);
-			vertices.push_back(bL);
-			vertices.push_back(tR);
-			vertices.push_back(tR);
-			vertices.push_back(bL);
-			vertices.push_back(bR);
-
-			drawCall c = Camera::FormatDrawCall(zIndex, NULL, NULL, vertices, AvgEngine::Render::Rect());
-			camera->addDrawCall(c);
+			vertices[0] = Render::Vertex(_x, _y, 0, 0, r, g, b, a);
+			vertices[1] = Render::Vertex(_toX, _toY, 0, 1, r, g, b, a);
+			vertices[2] = Render::Vertex(_x2, _y, 1, 0, r, g, b, a);
+			vertices[3] = Render::Vertex(_toX2, _toY, 1, 1, r, g, b, a);
 		}
 
 		static void DrawFilledPoints(Camera* camera, int zIndex, float tlX, float tlY, float trX, float trY, float blX, float blY, float brX, float brY, float r = 255, float g = 255, float b = 255, float a = 1, AvgEngine::Render::Rect clip = {-1,-1,-1,-1})
 		{
-			std::vector<Render::Vertex> vertices;
-
-			Render::Vertex tL = Render::Vertex(tlX, tlY, 0, 0, r / 255, g / 255, b / 255, a);
-			Render::Vertex tR = Render::Vertex(trX, trY, 1, 0, r / 255, g / 255, b / 255, a);
-			Render::Vertex bL = Render::Vertex(blX, blY, 0, 1, r / 255, g / 255, b / 255, a);
-			Render::Vertex bR = Render::Vertex(brX, brY, 1, 1, r / 255, g / 255, b / 255, a);
-
-
-			vertices.push_back(tL);
-			vertices.push_back(bL);
-			vertices.push_back(tR);
-			vertices.push_back(tR);
-			vertices.push_back(bL);
-			vertices.push_back(bR);
-
-			drawCall c = Camera::FormatDrawCall(zIndex, NULL, NULL, vertices, AvgEngine::Render::Rect());
+			drawCall c = Camera::FormatQuadCall(zIndex, NULL, NULL, {}, AvgEngine::Render::Rect());
 			if (clip.w != -1)
 				c.clip = clip;
-			camera->addDrawCall(c);
+			std::span<Render::Vertex> vertices = camera->reserveVertices(c, 4);
+
+			uint32_t colour = Render::Vertex::PackColour(r / 255, g / 255, b / 255, a);
+			vertices[0] = Render::Vertex(tlX, tlY, 0, 0, colour);
+			vertices[1] = Render::Vertex(blX, blY, 0, 1, colour);
+			vertices[2] = Render::Vertex(trX, trY, 1, 0, colour);
+			vertices[3] = Render::Vertex(brX, brY, 1, 1, colour);
 		}
 
 
@@ -195,26 +580,20 @@ namespace AvgEngine::Base
 		 */
 		static void DrawOutlinedRectangle(Camera* camera, int zIndex, float thickness, Render::Rect rect, Render::Rect clip = {})
 		{
-			std::vector<Render::Vertex> vertices;
-
 			Render::Rect topLine = { rect.x, rect.y, rect.w, thickness, rect.r, rect.g, rect.b, rect.a };
 			Render::Rect bottomLine = { rect.x, rect.y + rect.h, rect.w, thickness, rect.r, rect.g, rect.b, rect.a };
 			Render::Rect leftLine = { rect.x, rect.y, thickness, rect.h, rect.r, rect.g, rect.b, rect.a };
 			Render::Rect rightLine = { rect.x + rect.w, rect.y, thickness, rect.h + thickness, rect.r,rect.g,rect.b, rect.a };
 
-			for (Render::Vertex v : Render::DisplayHelper::RectToVertex(topLine, { 0,0,1,1 }))
-				vertices.push_back(v);
-			for (Render::Vertex v : Render::DisplayHelper::RectToVertex(bottomLine, { 0,0,1,1 }))
-				vertices.push_back(v);
-			for (Render::Vertex v : Render::DisplayHelper::RectToVertex(leftLine, { 0,0,1,1 }))
-				vertices.push_back(v);
-			for (Render::Vertex v : Render::DisplayHelper::RectToVertex(rightLine, { 0,0,1,1 }))
-				vertices.push_back(v);
-
-			drawCall c = Camera::FormatDrawCall(zIndex, NULL, NULL, vertices, topLine);
+			drawCall c = Camera::FormatQuadCall(zIndex, NULL, NULL, {}, topLine);
 			if (clip != Render::Rect{})
 				c.clip = clip;
-			camera->addDrawCall(c);
+			std::span<Render::Vertex> vertices = camera->reserveVertices(c, 16);
+
+			Render::DisplayHelper::RectToQuad(vertices.subspan<0, 4>(), topLine, { 0,0,1,1 });
+			Render::DisplayHelper::RectToQuad(vertices.subspan<4, 4>(), bottomLine, { 0,0,1,1 });
+			Render::DisplayHelper::RectToQuad(vertices.subspan<8, 4>(), leftLine, { 0,0,1,1 });
+			Render::DisplayHelper::RectToQuad(vertices.subspan<12, 4>(), rightLine, { 0,0,1,1 });
 		}
 
 		/**
@@ -225,10 +604,10 @@ namespace AvgEngine::Base
 		 */
 		static void DrawRectangle(Camera* camera, int zIndex, Render::Rect rect, Render::Rect clip = {})
 		{
-			drawCall c = Camera::FormatDrawCall(zIndex, NULL, NULL, Render::DisplayHelper::RectToVertex(rect, { 0,0,1,1 }), rect);
+			drawCall c = Camera::FormatQuadCall(zIndex, NULL, NULL, {}, rect);
 			if (clip != Render::Rect{})
 				c.clip = clip;
-			camera->addDrawCall(c);
+			Render::DisplayHelper::RectToQuad(camera->reserveVertices(c, 4).first<4>(), rect, { 0,0,1,1 });
 		}
 	};
 }
@@ -22,6 +22,8 @@ void AvgEngine::Base::GameObject::draw()
 				ob->parentClip = NULL;
 			ob->camera = camera;
 			ob->parent = &transform;
+			if (cullChild(ob))
+				continue;
 			int oldZ = ob->zIndex;
 			ob->zIndex += zIndex;
 			ob->draw();
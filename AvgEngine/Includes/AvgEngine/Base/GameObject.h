@@ -58,6 +58,9 @@ namespace AvgEngine::Base
 		std::vector<GameObject*> Children;
 
 		int id = 0;
+		/**
+		 * \brief The order this draws in (higher is on top). Added to the parent's, and the total has to stay between Camera::minZIndex and Camera::maxZIndex
+		 */
 		int zIndex = 0;
 
 		bool render = true;
@@ -110,6 +113,8 @@ namespace AvgEngine::Base
 						ob->parentClip = NULL;
 					ob->camera = camera;
 					ob->parent = &transform;
+					if (cullChild(ob))
+						continue;
 					int oldZ = ob->zIndex;
 					ob->zIndex += zIndex;
 					ob->draw();
@@ -118,6 +123,43 @@ namespace AvgEngine::Base
 			}
 		};
 
+		/**
+		 * \brief If this object, or anything under it, has a clip of its own (so a parent's clip doesn't hold everything it draws)
+		 */
+		bool clipsItself()
+		{
+			if (clipRect.w != 0 || clipRect.h != 0)
+				return true;
+			for (GameObject* ob : Children)
+				if (ob->clipsItself())
+					return true;
+			return false;
+		}
+
+		/**
+		 * \brief How many objects this is, counting everything under it
+		 */
+		int objectCount()
+		{
+			int count = 1;
+			for (GameObject* ob : Children)
+				count += ob->objectCount();
+			return count;
+		}
+
+		/**
+		 * \brief If a child (and everything under it) can be skipped because the clip it gets from this object can't be seen.
+		 * Skipped objects are counted as culled.
+		 * \param ob The child (with its parentClip already set)
+		 */
+		bool cullChild(GameObject* ob)
+		{
+			if (ob->parentClip == NULL || camera == NULL || camera->canSee(*ob->parentClip, Render::Rect()) || ob->clipsItself())
+				return false;
+			camera->culledObjects += ob->objectCount();
+			return true;
+		}
+
 		virtual void setRatio(bool ratio)
 		{
 			transformRatio = ratio;
@@ -11,6 +11,9 @@
 
 #include <AvgEngine/Utils/Logging.h>
 #include <AvgEngine/Base/GameObject.h>
+
+#include <algorithm>
+
 namespace AvgEngine::Base
 {
 	class Rectangle : public GameObject
@@ -90,6 +93,8 @@ namespace AvgEngine::Base
 		void draw() override
 		{
 
+			drawChildren(false);
+
 			Render::Rect r = transform;
 			Render::Rect cr = clipRect;
 			if (parent)
@@ -122,18 +127,32 @@ namespace AvgEngine::Base
 			if (cr.w == 0 && cr.h == 0 && parentClip)
 				cr = *parentClip;
 
-			if (r.x + r.w < 0 || r.x > camera->w || r.y + r.h < 0 || r.y > camera->h)
-				return;
-			
-			if (transform.a <= 0)
-				return;
-
-			drawChildren(false);
+			if (transform.a > 0)
+			{
+				Render::Rect outset = r;
+				outset.w += outlinedThickness;
+				outset.h += outlinedThickness;
+				Render::Rect bounds = Render::DisplayHelper::QuadBounds(outset);
+				if (outlinedThickness != 0)
+				{
+					// the outline's lines are drawn unscaled and unrotated, so the box has to cover those too
+					float x1 = std::max(bounds.x + bounds.w, outset.x + outset.w);
+					float y1 = std::max(bounds.y + bounds.h, outset.y + outset.h);
+					bounds.x = std::min(bounds.x, outset.x);
+					bounds.y = std::min(bounds.y, outset.y);
+					bounds.w = x1 - bounds.x;
+					bounds.h = y1 - bounds.y;
+				}
 
-			if (outlinedThickness == 0)
-				Primitives::DrawRectangle(camera, zIndex, r, cr);
-			else
-				Primitives::DrawOutlinedRectangle(camera, zIndex, outlinedThickness, r, cr);
+				// it can't be seen, but its children might be somewhere else
+				if (!camera->cull(bounds, cr))
+				{
+					if (outlinedThickness == 0)
+						Primitives::DrawRectangle(camera, zIndex, r, cr);
+					else
+						Primitives::DrawOutlinedRectangle(camera, zIndex, outlinedThickness, r, cr);
+				}
+			}
 			drawChildren(true);
 		}
 	};
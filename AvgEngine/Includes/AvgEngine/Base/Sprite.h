@@ -10,6 +10,8 @@
 
 #include <AvgEngine/Base/GameObject.h>
 #include <AvgEngine/Utils/Logging.h>
+#include <AvgEngine/Render/TextureAtlas.h>
+#include <AvgEngine/Render/TextureCache.h>
 
 namespace AvgEngine::Base
 {
@@ -24,6 +26,17 @@ namespace AvgEngine::Base
 
 		Render::Rect src;
 
+		/**
+		 * \brief The size of the atlas region this sprite came from (0 if it isn't from an atlas)
+		 */
+		int atlasWidth = 0;
+		int atlasHeight = 0;
+
+		/**
+		 * \brief The texture this sprite got from the TextureCache, which is released when the sprite is deleted (NULL if it didn't get one)
+		 */
+		AvgEngine::OpenGL::Texture* cachedTexture = NULL;
+
 		Sprite(float x, float y, char* data, size_t size) : GameObject(x, y)
 		{
 			src = { 0,0,1,1 };
@@ -55,35 +68,72 @@ namespace AvgEngine::Base
 		Sprite(float x, float y, std::string filePath) : GameObject(x, y)
 		{
 			src = { 0,0,1,1 };
-			texture = OpenGL::Texture::createWithImage(filePath);
+			cachedTexture = Render::TextureCache::GetDefault()->Acquire(filePath);
+			texture = cachedTexture;
 			transform.w = static_cast<float>(texture->width);
 			transform.h = static_cast<float>(texture->height);
 			iTransform = transform;
 		}
 
+		/**
+		 * \brief Creates a sprite from a packed atlas region (see Render::TextureAtlas)
+		 */
+		Sprite(float x, float y, Render::AtlasRegion region) : GameObject(x, y)
+		{
+			src = region.src;
+			texture = region.texture;
+			atlasWidth = region.width;
+			atlasHeight = region.height;
+			transform.w = static_cast<float>(atlasWidth);
+			transform.h = static_cast<float>(atlasHeight);
+			iTransform = transform;
+		}
+
+		~Sprite() override
+		{
+			if (cachedTexture && Render::TextureCache::instance)
+				Render::TextureCache::instance->Release(cachedTexture);
+		}
+
+		/**
+		 * \brief The width of the image this sprite shows (the region's size for atlas sprites, otherwise the texture's)
+		 */
+		float textureWidth()
+		{
+			return static_cast<float>(atlasWidth != 0 ? atlasWidth : texture->width);
+		}
+
+		/**
+		 * \brief The height of the image this sprite shows (the region's size for atlas sprites, otherwise the texture's)
+		 */
+		float textureHeight()
+		{
+			return static_cast<float>(atlasHeight != 0 ? atlasHeight : texture->height);
+		}
+
 		void recalculateRatio()
 		{
 			if (transformRatio)
 			{
 				if (parentI)
 				{
-					transform.w = (static_cast<float>(texture->width) / parentI->w);
-					transform.h = (static_cast<float>(texture->height) / parentI->h);
+					transform.w = (textureWidth() / parentI->w);
+					transform.h = (textureHeight() / parentI->h);
 					iTransform.w = (transform.w * parentI->w);
 					iTransform.h = (transform.h * parentI->h);
 				}
 				else
 				{
-					transform.w = (static_cast<float>(texture->width) / parent->w);
-					transform.h = (static_cast<float>(texture->height) / parent->h);
+					transform.w = (textureWidth() / parent->w);
+					transform.h = (textureHeight() / parent->h);
 					iTransform.w = (transform.w * parent->w);
 					iTransform.h = (transform.h * parent->h);
 				}
 			}
 			else
 			{
-				transform.w = texture->width;
-				transform.h = texture->height;
+				transform.w = textureWidth();
+				transform.h = textureHeight();
 				iTransform.w = transform.w;
 				iTransform.h = transform.h;
 			}
@@ -154,9 +204,9 @@ namespace AvgEngine::Base
 					r.y = parent->y + (parent->h * (r.y));
 
 					if (transform.w > 1)
-						transform.w = texture->width / parent->w;
+						transform.w = textureWidth() / parent->w;
 					if (transform.h > 1)
-						transform.h = texture->height / parent->h;
+						transform.h = textureHeight() / parent->h;
 
 					r.w = transform.w;
 					r.h = transform.h;
@@ -197,15 +247,22 @@ namespace AvgEngine::Base
 			r.w += transformOffset.w;
 			r.h += transformOffset.h;
 
+			Render::Rect clip;
+			if ((cr.w != 0 || cr.h != 0) && clipAll)
+				clip = cr;
+			if (cr.w == 0 && cr.h == 0 && parentClip)
+				clip = *parentClip;
+
 			if (transform.a > 0)
 			{
-				if (r.x + r.w < 0 || r.y + r.h < 0)
+				// it can't be seen, so it doesn't need vertices (its children might be somewhere else though)
+				if (camera->cull(Render::DisplayHelper::QuadBounds(r, center), clip))
 				{
 					drawn = false;
+					drawChildren(true);
 					return;
 				}
 
-
 				Render::Rect srcCopy = src; // normalize the coords for opengl
 
 				if (src.x > 1)
@@ -217,17 +274,18 @@ namespace AvgEngine::Base
 				if (src.h > 1)
 					srcCopy.h = src.h / texture->height;
 
-				drawCall c = Camera::FormatDrawCall(zIndex, texture, shader, Render::DisplayHelper::RectToVertex(r, srcCopy, center), iTransform);
+				// Instanced sprites only need their rect, the quad gets built on the GPU
+				bool instance = camera->instancedSprites && shader == NULL && Render::Display::instancedShader != NULL;
+
+				drawCall c = Camera::FormatQuadCall(zIndex, texture, shader, {}, iTransform);
 				c.tag = tag;
-				if ((cr.w != 0 || cr.h != 0) && clipAll)
-					c.clip = cr;
-				if (cr.w == 0 && cr.h == 0 && parentClip)
-					c.clip = *parentClip;
+				c.clip = clip;
 
-				if (camera->addDrawCall(c))
-					drawn = true;
+				if (instance)
+					camera->addInstance(c, Render::DisplayHelper::RectToInstance(r, srcCopy, center));
 				else
-					drawn = false;
+					Render::DisplayHelper::RectToQuad(camera->reserveVertices(c, 4).first<4>(), r, srcCopy, center);
+				drawn = true;
 			}
 
 			drawChildren(true);
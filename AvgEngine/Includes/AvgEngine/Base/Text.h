@@ -11,6 +11,8 @@
 
 #include <AvgEngine/External/SpriteFont/FntParser.h>
 #include <AvgEngine/Base/GameObject.h>
+#include <AvgEngine/Render/QuadBatch.h>
+#include <cfloat>
 
 namespace AvgEngine::Base
 {
@@ -30,6 +32,28 @@ namespace AvgEngine::Base
 	};
 
 
+	/**
+	 * \brief Everything a Text's glyph layout depends on (if none of it changes, the layout can be reused)
+	 */
+	struct TextLayoutKey
+	{
+		Fnt::Fnt* fnt = NULL;
+		std::string text = "";
+		float size = 0;
+		float outlineThickness = 0;
+		float characterSpacing = 0;
+		float scale = 1;
+		bool wrap = false;
+		bool centerLines = false;
+		bool sdf = false;
+		/**
+		 * \brief How far right of the origin a line can go before it wraps (only used when wrapping)
+		 */
+		float wrapLimit = 0;
+
+		bool operator==(const TextLayoutKey& other) const = default;
+	};
+
 	class Text : public GameObject
 	{
 	public:
@@ -43,8 +67,27 @@ namespace AvgEngine::Base
 
 		bool centerLines = false;
 
+		/**
+		 * \brief If this text is drawn from the font's distance field (scales cleanly, and outlines/shadows are done in the shader instead of extra glyphs)
+		 */
+		bool sdf = false;
+		/**
+		 * \brief How SDF text is outlined and shadowed (outlineThickness isn't used for SDF text)
+		 */
+		Fnt::SdfStyle sdfStyle{};
+
 		std::string text = "";
 
+		/**
+		 * \brief The laid out glyph quads (kept between draws, and only rebuilt when the layout changes)
+		 */
+		Render::QuadBatch glyphBatch;
+
+		/**
+		 * \brief Forces the layout to be rebuilt on the next draw
+		 */
+		bool layoutDirty = true;
+
 		Text(float x, float y, std::string folder, std::string font, std::string _text, float _size) : GameObject(x,y)
 		{
 			if (folder.size() != 0 && font.size() != 0)
@@ -63,16 +106,19 @@ namespace AvgEngine::Base
 		{
 			// this doesn't actually reload the font's texture if it already existed.
 			fnt = Fnt::Fnt::GetFont(folder, font);
+			layoutDirty = true;
 		}
 
 		void SetSize(float _size)
 		{
 			size = _size;
+			layoutDirty = true;
 		}
 
 		void SetText(std::string _text)
 		{
 			text = _text;
+			layoutDirty = true;
 		}
 
 		void draw() override
@@ -108,13 +154,227 @@ namespace AvgEngine::Base
 			}
 			drawn = true;
 
-			Render::Rect start = dst;
+			TextLayoutKey key;
+			key.fnt = fnt;
+			key.size = size;
+			key.outlineThickness = outlineThickness;
+			key.characterSpacing = characterSpacing;
+			key.scale = transform.scale;
+			key.wrap = wrap && parent;
+			key.centerLines = centerLines;
+			key.sdf = sdf && fnt->EnsureSdf();
+			if (key.wrap)
+				key.wrapLimit = parent->x + parent->w - dst.x;
+
+			// glyphs sit on whole pixels from the origin
+			int originX = static_cast<int>(dst.x);
+			int originY = static_cast<int>(dst.y);
+
+			if (layoutDirty || text != layoutKey.text || !sameLayout(key))
+			{
+				key.text = text;
+				layoutKey = key;
+				Layout(originX, originY);
+				layoutDirty = false;
+			}
+			else if (originX != layoutX || originY != layoutY)
+			{
+				// same layout, it just moved
+				float dx = static_cast<float>(originX - layoutX);
+				float dy = static_cast<float>(originY - layoutY);
+				for (float& x : glyphBatch.x)
+					x += dx;
+				for (float& y : glyphBatch.y)
+					y += dy;
+				layoutX = originX;
+				layoutY = originY;
+			}
+
+			if (transform.r != glyphColour.r || transform.g != glyphColour.g || transform.b != glyphColour.b || transform.a != glyphColour.a || transform.angle != glyphColour.angle)
+				ColourGlyphs();
 
-			drawCall call;
-			call.texture = fnt->texture;
-			call.shad = NULL;
-			call.zIndex = zIndex;
-			call.vertices = {};
+			Render::Rect r = dst;
+
+			if (centerLines)
+				r.x -= (transform.w / 2);
+
+			iTransform = r;
+
+			if (glyphBatch.size() != 0 && camera->cull(LineBounds(textBounds), cr))
+				drawn = false;
+			else if (glyphBatch.size() != 0)
+			{
+				// lines that can't be seen are skipped
+				size_t visible = 0;
+				for (glyphLine& line : glyphLines)
+				{
+					line.visible = camera->canSee(LineBounds(line), cr);
+					if (line.visible)
+						visible += line.count;
+				}
+
+				// every glyph goes into the same bucket, so expand them all straight into it
+				drawCall glyphs = Camera::FormatQuadCall(zIndex, layoutKey.sdf ? fnt->sdfTexture : fnt->texture, NULL, {}, iTransform);
+				if (layoutKey.sdf)
+					glyphs.shad = fnt->GetSdfShader(sdfStyle);
+				glyphs.clip = cr;
+				std::span<Render::Vertex> out = camera->reserveVertices(glyphs, visible * 4);
+				if (visible == glyphBatch.size())
+					glyphBatch.Expand(out);
+				else
+				{
+					for (glyphLine& line : glyphLines)
+					{
+						if (!line.visible)
+							continue;
+						glyphBatch.Expand(out.first(line.count * 4), line.first, line.count);
+						out = out.subspan(line.count * 4);
+					}
+				}
+			}
+
+			transform.w = layoutW;
+			transform.h = layoutH;
+			iTransform.w = layoutW;
+			iTransform.h = layoutH;
+			if (transformRatio)
+			{
+				transform.w = layoutW / parent->w;
+				transform.h = layoutH / parent->h;
+			}
+
+			GameObject::draw();
+		}
+
+	private:
+		/**
+		 * \brief A laid out line's glyphs in glyphBatch, and the box they fit in (relative to the layout's origin)
+		 */
+		struct glyphLine
+		{
+			size_t first = 0;
+			size_t count = 0;
+			float x0 = 0, y0 = 0, x1 = 0, y1 = 0;
+			/**
+			 * \brief The biggest glyph's size (rotating a glyph can push it out of the box by up to this)
+			 */
+			float glyph = 0;
+			/**
+			 * \brief If the line could be seen the last time it was drawn
+			 */
+			bool visible = true;
+		};
+
+		std::vector<glyphLine> glyphLines;
+		/**
+		 * \brief Every line's box together
+		 */
+		glyphLine textBounds;
+
+		TextLayoutKey layoutKey;
+		int layoutX = 0;
+		int layoutY = 0;
+		float layoutW = 0;
+		float layoutH = 0;
+		/**
+		 * \brief How many of the glyphs at the start of glyphBatch are outlines (they're drawn black)
+		 */
+		size_t outlineGlyphs = 0;
+		/**
+		 * \brief The colour and angle glyphBatch was last filled with
+		 */
+		Render::Rect glyphColour;
+
+		/**
+		 * \brief Compares everything but the text (so the string only gets compared once)
+		 */
+		bool sameLayout(TextLayoutKey key)
+		{
+			key.text.swap(layoutKey.text);
+			bool same = key == layoutKey;
+			key.text.swap(layoutKey.text);
+			return same;
+		}
+
+		/**
+		 * \brief Where a line (or the whole text) is right now
+		 */
+		Render::Rect LineBounds(const glyphLine& line)
+		{
+			float reach = transform.angle != 0 ? line.glyph : 0;
+			return Render::Rect(layoutX + line.x0 - reach, layoutY + line.y0 - reach, line.x1 - line.x0 + reach * 2, line.y1 - line.y0 + reach * 2);
+		}
+
+		/**
+		 * \brief Adds the glyphs from first to the end of glyphBatch as a line
+		 */
+		void AddLine(size_t first)
+		{
+			glyphLine line;
+			line.first = first;
+			line.count = glyphBatch.size() - first;
+			if (line.count == 0)
+				return;
+
+			line.x0 = line.y0 = FLT_MAX;
+			line.x1 = line.y1 = -FLT_MAX;
+			for (size_t i = first; i < glyphBatch.size(); i++)
+			{
+				float w = glyphBatch.w[i] * glyphBatch.scale[i];
+				float h = glyphBatch.h[i] * glyphBatch.scale[i];
+				line.x0 = std::min({ line.x0, glyphBatch.x[i], glyphBatch.x[i] + w });
+				line.y0 = std::min({ line.y0, glyphBatch.y[i], glyphBatch.y[i] + h });
+				line.x1 = std::max({ line.x1, glyphBatch.x[i], glyphBatch.x[i] + w });
+				line.y1 = std::max({ line.y1, glyphBatch.y[i], glyphBatch.y[i] + h });
+				line.glyph = std::max({ line.glyph, std::abs(w), std::abs(h) });
+			}
+			line.x0 -= layoutX;
+			line.x1 -= layoutX;
+			line.y0 -= layoutY;
+			line.y1 -= layoutY;
+
+			if (glyphLines.empty())
+				textBounds = line;
+			textBounds.x0 = std::min(textBounds.x0, line.x0);
+			textBounds.y0 = std::min(textBounds.y0, line.y0);
+			textBounds.x1 = std::max(textBounds.x1, line.x1);
+			textBounds.y1 = std::max(textBounds.y1, line.y1);
+			textBounds.glyph = std::max(textBounds.glyph, line.glyph);
+			glyphLines.push_back(line);
+		}
+
+		/**
+		 * \brief Writes the transform's colour and angle into every glyph
+		 */
+		void ColourGlyphs()
+		{
+			glyphColour = transform;
+			size_t count = glyphBatch.size();
+			for (size_t i = 0; i < count; i++)
+			{
+				bool outline = i < outlineGlyphs;
+				glyphBatch.r[i] = outline ? 0 : transform.r;
+				glyphBatch.g[i] = outline ? 0 : transform.g;
+				glyphBatch.b[i] = outline ? 0 : transform.b;
+				glyphBatch.a[i] = transform.a;
+				glyphBatch.angle[i] = transform.angle;
+			}
+		}
+
+		/**
+		 * \brief Lays out every glyph (outlines first) into glyphBatch
+		 * \param originX The x to start at
+		 * \param originY The y to start at
+		 */
+		void Layout(int originX, int originY)
+		{
+			layoutX = originX;
+			layoutY = originY;
+
+			Render::Rect dst;
+			dst.scale = transform.scale;
+			// SDF text does its outline in the shader
+			bool outlined = outlineThickness != 0 && !layoutKey.sdf;
 			int totalW = 0;
 			int highestH = 0;
 			float scale = size / fnt->ogSize;
@@ -126,23 +386,12 @@ namespace AvgEngine::Base
 			for(int i = 0; i < text.size(); i++)
 			{
 				char ch = text[i];
-				const Fnt::FntChar c = fnt->GetChar(ch);
+				const Fnt::FntChar& c = fnt->GetChar(ch);
 				if (c.id == -1)
 					continue;
 				float fileAdvance = static_cast<float>(c.xAdvance);
 				if (i + 1 < text.size() && fnt->hasKernings)
-				{
-					// check kerning
-					char next = text[i + 1];
-					for (int j = 0; j < c.kernings.size(); j++)
-					{
-						if (c.kernings[j].with == next)
-						{
-							fileAdvance -= c.kernings[j].amount;
-							break;
-						}
-					}
-				}
+					fileAdvance -= fnt->GetKerning(c.id, static_cast<unsigned char>(text[i + 1]));
 				float advance = ((fileAdvance * scale) + characterSpacing) * transform.scale;
 				if (ch == 32)
 				{
@@ -151,14 +400,14 @@ namespace AvgEngine::Base
 					l.advance = advance;
 					totalW += advance;
 					dst.x += advance;
-					if (wrap && dst.x + dst.w > parent->x + parent->w && wrap)
+					if (layoutKey.wrap && dst.x + dst.w > layoutKey.wrapLimit)
 					{
-						dst.x = start.x;
+						dst.x = 0;
 						dst.y += highestH;
 						d += highestH;
 						highestH = 0;
 						currentLine.w = totalW;
-						if (outlineThickness != 0)
+						if (outlined)
 						{
 							currentOutline.w = totalW;
 							outlines.push_back(currentOutline);
@@ -166,40 +415,28 @@ namespace AvgEngine::Base
 						lines.push_back(currentLine);
 						currentLine = {};
 						currentOutline = {};
-						if (totalW > transform.w)
-							transform.w = totalW;
 						totalW = 0;
 					}
-					if (outlineThickness != 0)
+					if (outlined)
 						currentOutline.characters.push_back(l);
 					currentLine.characters.push_back(l);
 					continue;
 				}
-				Render::Rect src = c.src;
 				dst.w = c.dst.w * scale;
 				dst.h = c.dst.h * scale;
 
-
 				if (highestH < dst.h)
 					highestH = dst.h;
 
 				CharacterLine l;
 				l.dst = dst;
-				l.src = src;
+				l.src = layoutKey.sdf ? c.sdfSrc : c.src;
 				l.advance = advance;
 
-				if (outlineThickness != 0)
+				if (outlined)
 				{
-					Render::Rect outline = dst;
-
-					outline.r = 0;
-					outline.g = 0;
-					outline.b = 0;
-					CharacterLine ll;
-					ll.dst = outline;
+					CharacterLine ll = l;
 					ll.outline = true;
-					ll.src = src;
-					ll.advance = advance;
 					currentOutline.characters.push_back(ll);
 				}
 				currentLine.characters.push_back(l);
@@ -207,40 +444,35 @@ namespace AvgEngine::Base
 				totalW += advance;
 			}
 			currentLine.w = totalW;
-			if (outlineThickness != 0)
+			if (outlined)
 			{
 				currentOutline.w = totalW;
 				outlines.push_back(currentOutline);
 			}
 			lines.push_back(currentLine);
-			currentLine = {};
-
 
 			if (d == 0)
 				d = highestH;
-			
-			float highestW = 0;
-
-			Render::Rect r = start;
 
-			if (centerLines)
-				r.x -= (transform.w / 2);
+			float highestW = 0;
 
-			iTransform = r;
+			glyphBatch.clear();
+			glyphLines.clear();
 
 			for (Line& line : outlines)
 			{
-				int newStartX = start.x;
+				size_t first = glyphBatch.size();
+				int newStartX = originX;
 				if (centerLines)
-					newStartX = start.x - (line.w / 2);
+					newStartX = originX - (line.w / 2);
 
 				int currentAdvance = 0;
 
 				for (CharacterLine& c : line.characters)
 				{
-					int newStartY = c.dst.y;
+					int newStartY = originY + c.dst.y;
 					if (centerLines)
-						newStartY = c.dst.y - (d / 2);
+						newStartY -= (d / 2);
 					c.dst.x = newStartX + currentAdvance;
 					c.dst.y = newStartY;
 					float outlineScale = (outlineThickness / 1);
@@ -251,68 +483,52 @@ namespace AvgEngine::Base
 					c.dst.w *= outlineScale;
 					c.dst.h *= outlineScale;
 					if (!c.space)
-					{
-						drawCall ca = Camera::FormatDrawCall(zIndex, fnt->texture, NULL, Render::DisplayHelper::RectToVertex(c.dst, c.src), iTransform);
-						ca.clip = cr;
-						ca.zIndex = zIndex;
-						camera->addDrawCall(ca);
-					}
+						glyphBatch.push(c.dst, c.src);
 					currentAdvance += c.advance;
 				}
+				AddLine(first);
 			}
 
+			outlineGlyphs = glyphBatch.size();
+
 			for(Line& line : lines)
 			{
+				size_t first = glyphBatch.size();
 				if (line.w > highestW)
 					highestW = line.w;
-				int newStartX = start.x;
+				int newStartX = originX;
 				if (centerLines)
-					newStartX = start.x - (line.w / 2);
+					newStartX = originX - (line.w / 2);
 
 				int currentAdvance = 0;
 
 				for(CharacterLine& c : line.characters)
 				{
-					int newStartY = c.dst.y;
+					int newStartY = originY + c.dst.y;
 					if (centerLines)
-						newStartY = c.dst.y - (d / 2);
+						newStartY -= (d / 2);
 					c.dst.x = newStartX + currentAdvance;
 					c.dst.y = newStartY;
-					if (c.outline)
+					if (layoutKey.sdf)
 					{
-						float outlineScale = (outlineThickness / 1);
-						float nX = (c.dst.w * (1 - outlineScale));
-						c.dst.x += nX / 2;
-						c.dst.y += (c.dst.h * (1 - outlineScale)) / 2;
-						c.dst.w *= outlineScale;
-						c.dst.h *= outlineScale;
+						// the field's glyphs are padded, so the quad grows to match
+						float pad = fnt->sdfSpread * scale;
+						c.dst.x -= pad * transform.scale;
+						c.dst.y -= pad * transform.scale;
+						c.dst.w += pad * 2;
+						c.dst.h += pad * 2;
 					}
 					if (!c.space)
-					{
-						drawCall ca = Camera::FormatDrawCall(zIndex, fnt->texture, NULL, Render::DisplayHelper::RectToVertex(c.dst, c.src), iTransform);
-						ca.clip = cr;
-						ca.zIndex = zIndex;
-						camera->addDrawCall(ca);
-					}
-					if (!c.outline)
-						currentAdvance += c.advance;
+						glyphBatch.push(c.dst, c.src);
+					currentAdvance += c.advance;
 				}
+				AddLine(first);
 			}
 
-			transform.w = highestW;
-			transform.h = d;
-			iTransform.w = highestW;
-			iTransform.h = d;
-			if (transformRatio)
-			{
-				transform.w = highestW / parent->w;
-				transform.h = d / parent->h;
-			}
-			call.clip = cr;
-			call.zIndex = zIndex;
-			camera->addDrawCall(call);
+			layoutW = highestW;
+			layoutH = d;
 
-			GameObject::draw();
+			ColourGlyphs();
 		}
 	};
 }
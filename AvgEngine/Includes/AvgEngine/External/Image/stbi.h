@@ -64,10 +64,12 @@ namespace AvgEngine::External
 		 * \param width The width of the image
 		 * \param x The x coordinate of the image to obtain
 		 * \param y The y coordinate of the image to obtain
-		 * \return A pixel struct with the data requested
+		 * \return A pixel struct with the data requested (all zeros if there's no data)
 		 */
 		static Pixel getPixelFromImage(unsigned char* data, int width, int x, int y)
 		{
+			if (data == NULL)
+				return Pixel();
 			unsigned char* pp = data + (4 * (y * width + x));
 
 			Pixel p;
@@ -83,11 +85,13 @@ namespace AvgEngine::External
 		 * \param data The image data to scan
 		 * \param width The width of the image
 		 * \param height The height of the image
-		 * \return The lightest pixel as a Pixel Struct
+		 * \return The lightest pixel as a Pixel Struct (all zeros if there's no data)
 		 */
 		static Pixel getLightestPixel(unsigned char* data, int width, int height)
 		{
 			Pixel lightest;
+			if (data == NULL)
+				return lightest;
 			int x = 0, y = 0;
 			for (int i = 0; i < width; i++)
 			{
@@ -110,12 +114,14 @@ namespace AvgEngine::External
 		 * \param data The image data to scan
 		 * \param width The width of the image
 		 * \param height The height of the image
-		 * \return The darkest pixel as a Pixel Struct
+		 * \return The darkest pixel as a Pixel Struct (all zeros if there's no data)
 		 */
 		static Pixel getDarkestPixel(unsigned char* data, int width, int height)
 		{
-			Pixel lightest = getLightestPixel(data, width, height);
 			Pixel darkest;
+			if (data == NULL)
+				return darkest;
+			Pixel lightest = getLightestPixel(data, width, height);
 			int x = 0, y = 0;
 			for (int i = 0; i < width; i++)
 			{
@@ -138,12 +144,14 @@ namespace AvgEngine::External
 		 * \param height The height of the image
 		 * \param toCompare The first pixel to compare
 		 * \param toCompare2 The second pixel to compare
-		 * \return The accent pixel as a Pixel Struct
+		 * \return The accent pixel as a Pixel Struct (toCompare if there's no data)
 		 */
 		static Pixel getAccentPixel(unsigned char* data, int width, int height, Pixel toCompare, Pixel toCompare2)
 		{
 			int x = 0, y = 0;
 			Pixel accent = toCompare;
+			if (data == NULL)
+				return accent;
 			for (int i = 0; i < width; i++)
 			{
 				x = i;
@@ -161,6 +169,38 @@ namespace AvgEngine::External
 			}
 			return accent;
 		}
+
+		/**
+		 * \brief getLightestPixel for a texture, reading its pixels back if they weren't kept (see Texture::Pixels). Has to be called on the GL thread.
+		 * \param texture The texture to scan
+		 * \return The lightest pixel as a Pixel Struct
+		 */
+		static Pixel getLightestPixel(AvgEngine::OpenGL::Texture* texture)
+		{
+			return getLightestPixel(texture->Pixels(), texture->width, texture->height);
+		}
+
+		/**
+		 * \brief getDarkestPixel for a texture, reading its pixels back if they weren't kept (see Texture::Pixels). Has to be called on the GL thread.
+		 * \param texture The texture to scan
+		 * \return The darkest pixel as a Pixel Struct
+		 */
+		static Pixel getDarkestPixel(AvgEngine::OpenGL::Texture* texture)
+		{
+			return getDarkestPixel(texture->Pixels(), texture->width, texture->height);
+		}
+
+		/**
+		 * \brief getAccentPixel for a texture, reading its pixels back if they weren't kept (see Texture::Pixels). Has to be called on the GL thread.
+		 * \param texture The texture to scan
+		 * \param toCompare The first pixel to compare
+		 * \param toCompare2 The second pixel to compare
+		 * \return The accent pixel as a Pixel Struct
+		 */
+		static Pixel getAccentPixel(AvgEngine::OpenGL::Texture* texture, Pixel toCompare, Pixel toCompare2)
+		{
+			return getAccentPixel(texture->Pixels(), texture->width, texture->height, toCompare, toCompare2);
+		}
 	};
 }
 
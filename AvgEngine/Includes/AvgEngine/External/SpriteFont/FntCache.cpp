@@ -0,0 +1,92 @@
+/*
+	Copyright 2021-2023 AvgEngine - Kade
+
+	Use of this source code without explict permission from owner is strictly prohibited.
+*/
+
+#include <AvgEngine/External/SpriteFont/FntCache.h>
+
+#include <fstream>
+#include <cstring>
+
+using namespace AvgEngine::Fnt;
+
+uint64_t FntCache::Checksum(const char* data, size_t size)
+{
+	uint64_t hash = 0xcbf29ce484222325ull;
+	for (size_t i = 0; i < size; i++)
+	{
+		hash ^= static_cast<unsigned char>(data[i]);
+		hash *= 0x100000001b3ull;
+	}
+	return hash;
+}
+
+bool FntCache::Read(std::string path, uint64_t checksum, FntData& out)
+{
+	std::ifstream file(path, std::ios::binary | std::ios::ate);
+	if (!file.is_open())
+		return false;
+
+	// read the whole thing in one go, then walk it like it was mapped
+	std::streamsize size = file.tellg();
+	if (size < static_cast<std::streamsize>(sizeof(FntCacheHeader)))
+		return false;
+	std::vector<char> blob(static_cast<size_t>(size));
+	file.seekg(0);
+	if (!file.read(blob.data(), size))
+		return false;
+
+	FntCacheHeader header;
+	std::memcpy(&header, blob.data(), sizeof(header));
+
+	FntCacheHeader expected;
+	if (std::memcmp(header.magic, expected.magic, sizeof(header.magic)) != 0 || header.version != expected.version || header.checksum != checksum)
+		return false;
+
+	size_t needed = sizeof(FntCacheHeader) + header.nameLength + header.pageLength +
+		static_cast<size_t>(header.charCount) * sizeof(FntCacheChar) +
+		static_cast<size_t>(header.kerningCount) * sizeof(FntCacheKerning);
+	if (needed != blob.size())
+		return false;
+
+	const char* at = blob.data() + sizeof(FntCacheHeader);
+
+	out.ogSize = header.ogSize;
+	out.hasKernings = header.hasKernings != 0;
+	out.name.assign(at, header.nameLength);
+	at += header.nameLength;
+	out.page.assign(at, header.pageLength);
+	at += header.pageLength;
+
+	out.chars.resize(header.charCount);
+	std::memcpy(out.chars.data(), at, header.charCount * sizeof(FntCacheChar));
+	at += header.charCount * sizeof(FntCacheChar);
+
+	out.kernings.resize(header.kerningCount);
+	std::memcpy(out.kernings.data(), at, header.kerningCount * sizeof(FntCacheKerning));
+	return true;
+}
+
+bool FntCache::Write(std::string path, uint64_t checksum, const FntData& data)
+{
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	if (!file.is_open())
+		return false;
+
+	FntCacheHeader header;
+	header.checksum = checksum;
+	header.ogSize = data.ogSize;
+	header.nameLength = static_cast<uint32_t>(data.name.size());
+	header.pageLength = static_cast<uint32_t>(data.page.size());
+	header.charCount = static_cast<uint32_t>(data.chars.size());
+	header.kerningCount = static_cast<uint32_t>(data.kernings.size());
+	header.hasKernings = data.hasKernings ? 1 : 0;
+
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	file.write(data.name.data(), data.name.size());
+	file.write(data.page.data(), data.page.size());
+	file.write(reinterpret_cast<const char*>(data.chars.data()), data.chars.size() * sizeof(FntCacheChar));
+	file.write(reinterpret_cast<const char*>(data.kernings.data()), data.kernings.size() * sizeof(FntCacheKerning));
+	return file.good();
+}
@@ -0,0 +1,108 @@
+/*
+	Copyright 2021-2023 AvgEngine - Kade
+
+	Use of this source code without explict permission from owner is strictly prohibited.
+*/
+
+#ifndef FNTCACHE_H
+#define FNTCACHE_H
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+namespace AvgEngine::Fnt
+{
+	/**
+	 * \brief A glyph as it's stored in a font cache (pixel coords, the texture isn't known until load)
+	 */
+	struct FntCacheChar
+	{
+		int32_t id = -1;
+		int32_t xAdvance = 0;
+		float x = 0, y = 0, w = 0, h = 0;
+	};
+
+	struct FntCacheKerning
+	{
+		uint32_t first = 0;
+		int32_t second = 0;
+		int32_t amount = 0;
+	};
+
+	/**
+	 * \brief The header at the start of a font cache. Everything after it is flat arrays, in this order:
+	 * name (nameLength bytes), page (pageLength bytes), chars (FntCacheChar x charCount), kernings (FntCacheKerning x kerningCount)
+	 */
+	struct FntCacheHeader
+	{
+		char magic[4] = { 'A', 'V', 'G', 'F' };
+		uint32_t version = 1;
+		/**
+		 * \brief The checksum of the .fnt this cache was made from
+		 */
+		uint64_t checksum = 0;
+		int32_t ogSize = 0;
+		uint32_t nameLength = 0;
+		uint32_t pageLength = 0;
+		uint32_t charCount = 0;
+		uint32_t kerningCount = 0;
+		/**
+		 * \brief If the source had a kernings node (even an empty one)
+		 */
+		uint32_t hasKernings = 0;
+	};
+
+	/**
+	 * \brief Everything a Fnt is built from, either parsed from a .fnt or read from its cache
+	 */
+	struct FntData
+	{
+		std::string name = "";
+		/**
+		 * \brief The texture file, relative to the font's folder
+		 */
+		std::string page = "";
+		int ogSize = 0;
+		bool hasKernings = false;
+		std::vector<FntCacheChar> chars{};
+		std::vector<FntCacheKerning> kernings{};
+	};
+
+	/**
+	 * \brief A binary precompiled version of a BMFont .fnt, so fonts don't have to be parsed from XML every launch
+	 */
+	class FntCache
+	{
+	public:
+		/**
+		 * \brief A FNV-1a hash of some data, used to tell if a cache is out of date
+		 * \param data The data
+		 * \param size The size of the data
+		 * \return The checksum
+		 */
+		static uint64_t Checksum(const char* data, size_t size);
+
+		/**
+		 * \brief Reads a font cache
+		 * \param path The path of the cache
+		 * \param checksum The checksum of the source .fnt (the cache is ignored if it doesn't match)
+		 * \param out A reference to the data to fill
+		 * \return If the cache existed, was valid, and matched the checksum
+		 */
+		static bool Read(std::string path, uint64_t checksum, FntData& out);
+
+		/**
+		 * \brief Writes a font cache
+		 * \param path The path to write to
+		 * \param checksum The checksum of the source .fnt
+		 * \param data The data to write
+		 * \return If it was written
+		 */
+		static bool Write(std::string path, uint64_t checksum, const FntData& data);
+	};
+}
+
+#endif // !FNTCACHE_H
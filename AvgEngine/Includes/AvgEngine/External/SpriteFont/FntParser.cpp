@@ -1,3 +1,127 @@
 #include <AvgEngine/External/SpriteFont/FntParser.h>
+#include <AvgEngine/Render/DistanceField.h>
+#include <AvgEngine/Render/TextureAtlas.h>
 
-std::vector<AvgEngine::Fnt::Fnt*>* AvgEngine::Fnt::Fnt::fonts = NULL;
\ No newline at end of file
+#include <algorithm>
+
+std::unordered_map<std::string, AvgEngine::Fnt::Fnt*>* AvgEngine::Fnt::Fnt::fonts = NULL;
+std::unordered_map<std::string, AvgEngine::Fnt::FntPreload> AvgEngine::Fnt::Fnt::loading{};
+std::mutex AvgEngine::Fnt::Fnt::fontsMutex;
+
+bool AvgEngine::Fnt::Fnt::BuildSdf(int spread)
+{
+	// the font's pixels usually aren't kept after upload, so they're read back just for this
+	bool hadPixels = texture != NULL && texture->pixels != NULL;
+	if (texture == NULL || texture->width == 0 || texture->Pixels() == NULL)
+	{
+		Logging::writeLog("[Fnt] [Warning] Couldn't get " + fontFile + "'s pixels, so it can't have a distance field.");
+		return false;
+	}
+
+	// pack every padded glyph into one page, growing it until they all fit
+	std::vector<FntChar*> glyphs;
+	size_t area = 0;
+	for (FntChar& c : chars)
+	{
+		if (c.dst.w <= 0 || c.dst.h <= 0)
+			continue;
+		// a page that didn't load is the 1x1 white texture, which the glyphs don't fit in
+		if (c.dst.x < 0 || c.dst.y < 0 || c.dst.x + c.dst.w > texture->width || c.dst.y + c.dst.h > texture->height)
+		{
+			Logging::writeLog("[Fnt] [Warning] " + fontFile + " has glyphs outside its page, so it can't have a distance field.");
+			if (!hadPixels)
+				texture->ReleasePixels();
+			return false;
+		}
+		glyphs.push_back(&c);
+		area += static_cast<size_t>(c.dst.w + spread * 2 + 1) * static_cast<size_t>(c.dst.h + spread * 2 + 1);
+	}
+	std::sort(glyphs.begin(), glyphs.end(), [](const FntChar* a, const FntChar* b) {
+		return a->dst.h > b->dst.h;
+	});
+
+	int size = 64;
+	while (static_cast<size_t>(size) * size < area)
+		size *= 2;
+
+	std::vector<std::pair<int, int>> spots(glyphs.size());
+	for (;; size *= 2)
+	{
+		if (size > 8192)
+		{
+			Logging::writeLog("[Fnt] [Warning] " + fontFile + "'s distance field doesn't fit in a page.");
+			if (!hadPixels)
+				texture->ReleasePixels();
+			return false;
+		}
+
+		Render::AtlasPage page;
+		page.size = size;
+		page.skyline.push_back({ 0, 0, size });
+
+		bool fit = true;
+		for (size_t i = 0; i < glyphs.size() && fit; i++)
+		{
+			// the extra pixel keeps neighbours from bleeding into each other
+			int w = static_cast<int>(glyphs[i]->dst.w) + spread * 2 + 1;
+			int h = static_cast<int>(glyphs[i]->dst.h) + spread * 2 + 1;
+			fit = page.Pack(w, h, &spots[i].first, &spots[i].second);
+		}
+		if (fit)
+			break;
+	}
+
+	std::vector<unsigned char> field(static_cast<size_t>(size) * size * 4, 0);
+	for (size_t i = 0; i < glyphs.size(); i++)
+	{
+		FntChar& c = *glyphs[i];
+		int w = static_cast<int>(c.dst.w);
+		int h = static_cast<int>(c.dst.h);
+		int x = spots[i].first;
+		int y = spots[i].second;
+		Render::DistanceField::Generate(texture->pixels, texture->width, static_cast<int>(c.dst.x), static_cast<int>(c.dst.y), w, h, spread,
+			field.data() + (static_cast<size_t>(y) * size + x) * 4, size);
+
+		float s = static_cast<float>(size);
+		c.sdfSrc = { x / s, y / s, (w + spread * 2) / s, (h + spread * 2) / s };
+	}
+
+	if (!hadPixels)
+		texture->ReleasePixels();
+
+	sdfTexture = new OpenGL::Texture(field.data(), size, size);
+	sdfTexture->pixels = NULL;
+	sdfSpread = spread;
+
+#ifdef _DEBUG
+	Logging::writeLog("[Fnt] [Debug] Built a " + std::to_string(size) + "x" + std::to_string(size) + " distance field for " + fontFile);
+#endif
+	return true;
+}
+
+AvgEngine::OpenGL::Shader* AvgEngine::Fnt::Fnt::GetSdfShader(const SdfStyle& style)
+{
+	for (auto& [s, shader] : sdfShaders)
+		if (s == style)
+			return shader;
+
+	OpenGL::Shader* shader = new OpenGL::Shader();
+	shader->GL_CompileShader(NULL, OpenGL::sdf_shader_frag);
+
+	float range = static_cast<float>(sdfSpread * 2);
+	float size = static_cast<float>(sdfTexture->width);
+	static const OpenGL::UniformHandle outline = OpenGL::Shader::Handle("u_outline");
+	static const OpenGL::UniformHandle outlineColour = OpenGL::Shader::Handle("u_outlineColour");
+	static const OpenGL::UniformHandle shadowOffset = OpenGL::Shader::Handle("u_shadowOffset");
+	static const OpenGL::UniformHandle shadowColour = OpenGL::Shader::Handle("u_shadowColour");
+	static const OpenGL::UniformHandle shadowSoftness = OpenGL::Shader::Handle("u_shadowSoftness");
+	shader->SetUniform(outline, std::clamp(style.outline / range, 0.0f, 0.5f));
+	shader->SetUniform(outlineColour, style.outlineR / 255, style.outlineG / 255, style.outlineB / 255, style.outlineA);
+	shader->SetUniform(shadowOffset, style.shadowX / size, style.shadowY / size);
+	shader->SetUniform(shadowColour, style.shadowR / 255, style.shadowG / 255, style.shadowB / 255, style.shadowA);
+	shader->SetUniform(shadowSoftness, style.shadowSoftness / range);
+	Render::Display::AddProjectedShader(shader);
+
+	sdfShaders.push_back({ style, shader });
+	return shader;
+}
@@ -12,10 +12,20 @@
 #include <AvgEngine/Render/Display.h>
 #include <AvgEngine/External/XML/pugixml.hpp>
 #include <AvgEngine/Render/OpenGL/Texture.h>
+#include <AvgEngine/Render/OpenGL/Shader.h>
+#include <AvgEngine/External/SpriteFont/FntCache.h>
 
 #include <AvgEngine/Utils/Logging.h>
 
 #include <vector>
+#include <array>
+#include <unordered_map>
+#include <cstdint>
+#include <fstream>
+#include <iterator>
+#include <future>
+#include <mutex>
+#include <chrono>
 
 namespace AvgEngine::Fnt
 {
@@ -31,6 +41,10 @@ namespace AvgEngine::Fnt
 		int id = -1;
 		int xAdvance = 0;
 		std::vector<Kerning> kernings;
+		/**
+		 * \brief Where this character is in the font's distance field page (includes the field's padding, see Fnt::sdfSpread)
+		 */
+		Render::Rect sdfSrc{};
 
 		bool operator<(const FntChar& a) const
 		{
@@ -38,10 +52,62 @@ namespace AvgEngine::Fnt
 		}
 	};
 
+	/**
+	 * \brief How SDF text is drawn. Distances are in the font's pixels (at its original size), and colours are 0-255 (alpha 0-1) like Rect.
+	 */
+	struct SdfStyle
+	{
+		/**
+		 * \brief How far past the edge the outline goes (up to the font's sdfSpread)
+		 */
+		float outline = 0;
+		float outlineR = 0, outlineG = 0, outlineB = 0, outlineA = 1;
+
+		float shadowX = 0, shadowY = 0;
+		float shadowSoftness = 0;
+		/**
+		 * \brief The shadow's colour (no shadow by default, since its alpha is 0)
+		 */
+		float shadowR = 0, shadowG = 0, shadowB = 0, shadowA = 0;
+
+		bool operator==(const SdfStyle& other) const = default;
+	};
+
+	/**
+	 * \brief The CPU side of loading a font (everything but its texture), so it can be done off the GL thread
+	 */
+	struct FntLoad
+	{
+		FntData data;
+		/**
+		 * \brief Log lines from loading (they get written when the font is finished on the GL thread)
+		 */
+		std::vector<std::string> log{};
+		bool ok = false;
+	};
+
+	/**
+	 * \brief A font being loaded on a worker thread, and where it's from
+	 */
+	struct FntPreload
+	{
+		std::string folder;
+		std::string file;
+		std::shared_future<FntLoad> load;
+	};
+
 	class Fnt
 	{
 	public:
-		static std::vector<Fnt*>* fonts;
+		/**
+		 * \brief Every loaded font, keyed by FontKey(folder, file)
+		 */
+		static std::unordered_map<std::string, Fnt*>* fonts;
+		/**
+		 * \brief Fonts being preloaded on worker threads, keyed by FontKey(folder, file)
+		 */
+		static std::unordered_map<std::string, FntPreload> loading;
+		static std::mutex fontsMutex;
 		std::vector<FntChar> chars{};
 		std::string fontFile = "";
 		std::string name = "";
@@ -51,8 +117,46 @@ namespace AvgEngine::Fnt
 
 		AvgEngine::OpenGL::Texture* texture = NULL;
 
+		/**
+		 * \brief Index into chars for every ASCII/Latin-1 character (-1 if the font doesn't have it)
+		 */
+		std::array<int, 256> latinIndex = MakeEmptyIndex();
+		/**
+		 * \brief Index into chars for everything above Latin-1
+		 */
+		std::unordered_map<unsigned int, int> wideIndex{};
+		/**
+		 * \brief Kerning amounts keyed by (first, second), see KerningKey
+		 */
+		std::unordered_map<uint64_t, int> kerningPairs{};
+
+		/**
+		 * \brief The distance field version of texture (NULL until it's built, see BuildSdf)
+		 */
+		AvgEngine::OpenGL::Texture* sdfTexture = NULL;
+		/**
+		 * \brief How many pixels the distance field reaches past each glyph's edge
+		 */
+		int sdfSpread = 0;
+		/**
+		 * \brief A shader for every SdfStyle that's been drawn with this font
+		 */
+		std::vector<std::pair<SdfStyle, OpenGL::Shader*>> sdfShaders{};
+
+		static uint64_t KerningKey(unsigned int first, unsigned int second)
+		{
+			return (static_cast<uint64_t>(first) << 32) | second;
+		}
+
 		static void ClearCache()
 		{
+			{
+				// let any preloads finish first, their results just get thrown out
+				std::lock_guard<std::mutex> lock(fontsMutex);
+				for (auto& [key, preload] : loading)
+					preload.load.wait();
+				loading.clear();
+			}
 			if (fonts->size() == 0)
 			{
 				#ifdef _DEBUG
@@ -63,7 +167,7 @@ namespace AvgEngine::Fnt
 			#ifdef _DEBUG
 			Logging::writeLog("[Fnt] [Debug] Clearing " + std::to_string(fonts->size()) + " fonts.");
 			#endif
-			for (Fnt* f : *fonts)
+			for (auto& [key, f] : *fonts)
 			{
 				delete f;
 			}
@@ -73,97 +177,324 @@ namespace AvgEngine::Fnt
 			#endif
 		}
 
-		static Fnt* GetFont(std::string folder, std::string font)
+		static std::string FontKey(const std::string& folder, const std::string& font)
 		{
-			for (Fnt* f : *fonts)
-				if (f->fontFile == font)
-					return f;
-			#ifdef _DEBUG 
-			Logging::writeLog("[Fnt] [Debug] First time load of " + font + ". Adding to cache...");
-			#endif
-			fonts->push_back(new Fnt(font, folder));
-			for (Fnt* f : *fonts)
-				if (f->fontFile == font)
-					return f;
+			return folder + "/" + font;
 		}
 
-		FntChar GetChar(char c)
+		/**
+		 * \brief Get a font, loading it if it hasn't been loaded yet (if it's being preloaded, this waits for it)
+		 * \param folder The folder the font is in
+		 * \param font The .fnt file
+		 * \return The font
+		 */
+		static Fnt* GetFont(std::string folder, std::string font)
 		{
-			unsigned int u = c;
+			std::string key = FontKey(folder, font);
+			std::shared_future<FntLoad> pending;
+			{
+				std::lock_guard<std::mutex> lock(fontsMutex);
+				auto it = fonts->find(key);
+				if (it != fonts->end())
+					return it->second;
 
-			auto it = std::find_if(chars.begin(), chars.end(), [&u](const FntChar& obj) {return obj.id == u; });
+				auto l = loading.find(key);
+				if (l != loading.end())
+				{
+					pending = l->second.load;
+					loading.erase(l);
+				}
+			}
 
-			if (it != chars.end())
-				return *it;
-			
-			FntChar cc;
-			cc.id = -1;
+			Fnt* f = NULL;
+			if (pending.valid())
+				f = new Fnt(font, folder, pending.get());
+			else
+			{
+				#ifdef _DEBUG 
+				Logging::writeLog("[Fnt] [Debug] First time load of " + font + ". Adding to cache...");
+				#endif
+				f = new Fnt(font, folder);
+			}
 
-			return cc;
+			std::lock_guard<std::mutex> lock(fontsMutex);
+			(*fonts)[key] = f;
+			return f;
 		}
 
-		FntChar GetWChar(wchar_t c)
+		/**
+		 * \brief Starts loading a font on a worker thread. Call FinishPreloads on the GL thread to give it a texture (or just GetFont it)
+		 * \param folder The folder the font is in
+		 * \param font The .fnt file
+		 */
+		static void Preload(std::string folder, std::string font)
 		{
-			unsigned int u = c;
+			std::string key = FontKey(folder, font);
+			std::lock_guard<std::mutex> lock(fontsMutex);
+			if (fonts->contains(key) || loading.contains(key))
+				return;
 
-			auto it = std::find_if(chars.begin(), chars.end(), [&u](const FntChar& obj) {return obj.id == u; });
+			loading[key] = { folder, font, std::async(std::launch::async, [folder, font]() {
+				FntLoad load;
+				load.ok = Load(folder, font, load.data, load.log);
+				return load;
+			}).share() };
+		}
 
-			if (it != chars.end())
-				return *it;
+		/**
+		 * \brief Finishes every preload that's done parsing (creating their textures). Has to be called on the GL thread.
+		 * \return How many preloads are still going
+		 */
+		static size_t FinishPreloads()
+		{
+			std::vector<std::pair<std::string, FntPreload>> done;
+			size_t left = 0;
+			{
+				std::lock_guard<std::mutex> lock(fontsMutex);
+				if (loading.size() == 0)
+					return 0;
+				for (auto it = loading.begin(); it != loading.end();)
+				{
+					if (it->second.load.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+					{
+						done.emplace_back(it->first, it->second);
+						it = loading.erase(it);
+					}
+					else
+						++it;
+				}
+				left = loading.size();
+			}
 
-			FntChar cc;
-			cc.id = -1;
+			for (auto& [key, preload] : done)
+			{
+				Fnt* f = new Fnt(preload.file, preload.folder, preload.load.get());
+				std::lock_guard<std::mutex> lock(fontsMutex);
+				(*fonts)[key] = f;
+			}
+			return left;
+		}
 
-			return cc;
+		/**
+		 * \brief Find a character by its id
+		 * \param id The character's code point
+		 * \return A pointer to the character, or NULL if the font doesn't have it
+		 */
+		const FntChar* FindChar(unsigned int id) const
+		{
+			if (id < latinIndex.size())
+			{
+				int i = latinIndex[id];
+				return i == -1 ? NULL : &chars[i];
+			}
+
+			auto it = wideIndex.find(id);
+			if (it != wideIndex.end())
+				return &chars[it->second];
+			return NULL;
+		}
+
+		/**
+		 * \brief Get a character (a character with an id of -1 if the font doesn't have it)
+		 */
+		const FntChar& GetChar(char c) const
+		{
+			const FntChar* ch = FindChar(static_cast<unsigned char>(c));
+			return ch ? *ch : MissingChar();
+		}
+
+		const FntChar& GetWChar(wchar_t c) const
+		{
+			const FntChar* ch = FindChar(static_cast<unsigned int>(c));
+			return ch ? *ch : MissingChar();
 		}
 
 		FntChar* GetCharPtr(char c)
 		{
-			unsigned int u = c;
+			return const_cast<FntChar*>(FindChar(static_cast<unsigned char>(c)));
+		}
 
-			for (FntChar& cc : chars)
-				if (cc.id == u)
-					return &cc;
+		/**
+		 * \brief Get how much closer two characters should be drawn together
+		 * \param first The first character's id
+		 * \param second The id of the character after it
+		 * \return The kerning amount (0 if there isn't one)
+		 */
+		int GetKerning(unsigned int first, unsigned int second) const
+		{
+			if (kerningPairs.size() == 0)
+				return 0;
+			auto it = kerningPairs.find(KerningKey(first, second));
+			return it == kerningPairs.end() ? 0 : it->second;
+		}
 
-			return NULL;
+		/**
+		 * \brief Rebuilds the character lookup tables (call this after changing chars)
+		 */
+		void BuildLookup()
+		{
+			latinIndex.fill(-1);
+			wideIndex.clear();
+			for (int i = 0; i < static_cast<int>(chars.size()); i++)
+			{
+				if (chars[i].id < 0)
+					continue;
+				unsigned int id = chars[i].id;
+				if (id < latinIndex.size())
+					latinIndex[id] = i;
+				else
+					wideIndex[id] = i;
+			}
 		}
 
 		Fnt() = default;
 
+		/**
+		 * \brief If fonts should be loaded from (and saved to) a binary cache next to their .fnt
+		 */
+		static inline bool useCache = true;
+
+		/**
+		 * \brief If every font should build its distance field when it loads (otherwise it's built the first time SDF text uses it)
+		 */
+		static inline bool buildSdf = false;
+
+		/**
+		 * \brief Builds a distance field page from the font's texture, with every glyph padded by spread. Has to be called on the GL thread.
+		 * \param spread How many pixels the field reaches past each glyph's edge
+		 * \return If it was built (the texture's pixels have to be readable)
+		 */
+		bool BuildSdf(int spread = 6);
+
+		/**
+		 * \brief Makes sure the distance field is built (only trying once)
+		 * \return If there's a distance field to draw with
+		 */
+		bool EnsureSdf()
+		{
+			if (sdfTexture)
+				return true;
+			if (sdfFailed)
+				return false;
+			sdfFailed = !BuildSdf();
+			return !sdfFailed;
+		}
+
+		/**
+		 * \brief Gets (or makes) the shader for drawing this font's distance field with a style
+		 * \param style The style
+		 * \return The shader
+		 */
+		OpenGL::Shader* GetSdfShader(const SdfStyle& style);
+
 		Fnt(std::string file, std::string folder)
 		{
 			fontFile = file;
+			FntLoad load;
+			load.ok = Load(folder, file, load.data, load.log);
+			Finish(folder, load);
+		}
+
+		/**
+		 * \brief Creates a font from data that's already been loaded (see Load)
+		 */
+		Fnt(std::string file, std::string folder, const FntLoad& load)
+		{
+			fontFile = file;
+			Finish(folder, load);
+		}
+
+		~Fnt()
+		{
+			for (auto& [style, shader] : sdfShaders)
+			{
+				Render::Display::RemoveProjectedShader(shader);
+				delete shader;
+			}
+			sdfShaders.clear();
+			delete sdfTexture;
+			sdfTexture = NULL;
+		}
+
+		/**
+		 * \brief Loads a font's data from its cache, or parses it (and writes the cache). Doesn't touch GL, so it's safe to call off the GL thread.
+		 * \param folder The folder the font is in
+		 * \param file The .fnt file
+		 * \param out A reference to the data to fill
+		 * \param log A reference to a list of log lines to add to
+		 * \return If the font could be loaded
+		 */
+		static bool Load(std::string folder, std::string file, FntData& out, std::vector<std::string>& log)
+		{
+			std::string path = folder + "/" + file;
+
+			std::ifstream source(path, std::ios::binary);
+			if (!source.is_open())
+			{
+				log.push_back("[FNT] [Error] Failed to parse " + path);
+				return false;
+			}
+			std::string xml((std::istreambuf_iterator<char>(source)), std::istreambuf_iterator<char>());
+			source.close();
+
+			uint64_t checksum = FntCache::Checksum(xml.data(), xml.size());
+			std::string cachePath = path + ".cache";
+
+			if (useCache && FntCache::Read(cachePath, checksum, out))
+			{
+#ifdef _DEBUG
+				log.push_back("[Fnt] [Debug] Loaded " + file + " from its cache.");
+#endif
+				return true;
+			}
+
+			if (!Parse(xml, file, out, log))
+				return false;
+			if (useCache && !FntCache::Write(cachePath, checksum, out))
+				log.push_back("[Fnt] [Warning] Couldn't write a cache for " + file);
+			return true;
+		}
+
+		/**
+		 * \brief Parses a .fnt (BMFont XML)
+		 * \param xml The contents of the file
+		 * \param file The file name (for logging)
+		 * \param out A reference to the data to fill
+		 * \param log A reference to a list of log lines to add to
+		 * \return If it had everything a font needs (info, pages, and chars)
+		 */
+		static bool Parse(const std::string& xml, std::string file, FntData& out, std::vector<std::string>& log)
+		{
 			pugi::xml_document doc;
-			pugi::xml_parse_result result = doc.load_file((folder + "/" + file).c_str());
+			pugi::xml_parse_result result = doc.load_buffer(xml.data(), xml.size());
 			if (!result)
 			{
-				Logging::writeLog("[FNT] [Error] Failed to parse " + (folder + "/" + file));
-				return;
+				log.push_back("[FNT] [Error] Failed to parse " + file);
+				return false;
 			}
 
 			pugi::xml_node n = doc.child("font").child("info");
 
 			if (n != NULL)
 			{
-				name = n.attribute("face").as_string();
-				ogSize = n.attribute("size").as_int();
+				out.name = n.attribute("face").as_string();
+				out.ogSize = n.attribute("size").as_int();
 			}
 			else
 			{
-				Logging::writeLog("[FNT] [Error] " + file + " doesn't have a info node.");
-				return;
+				log.push_back("[FNT] [Error] " + file + " doesn't have a info node.");
+				return false;
 			}
 
 			n = doc.child("font").child("pages");
 			if (n != NULL)
 			{
-				std::string toLoad = folder + "/" + n.first_child().attribute("file").as_string();
-				texture = OpenGL::Texture::createWithImage(toLoad);
+				out.page = n.first_child().attribute("file").as_string();
 			}
 			else
 			{
-				Logging::writeLog("[FNT] [Error] " + file + " doesn't have a pages node.");
-				return;
+				log.push_back("[FNT] [Error] " + file + " doesn't have a pages node.");
+				return false;
 			}
 
 			n = doc.child("font").child("chars");
@@ -171,64 +502,131 @@ namespace AvgEngine::Fnt
 			{
 				for (pugi::xml_node c : n)
 				{
-					FntChar ch;
+					FntCacheChar ch;
 					ch.xAdvance = c.attribute("xadvance").as_int();
 					ch.id = c.attribute("id").as_int();
-
-					float x = c.attribute("x").as_float();
-					float y = c.attribute("y").as_float();
-					float w = c.attribute("width").as_float();
-					float h = c.attribute("height").as_float();
-
-					ch.dst = { x, y, w, h };
-
-					ch.src = { x / texture->width, y / texture->height,w / texture->width, h / texture->height };
-					chars.push_back(ch);
+					ch.x = c.attribute("x").as_float();
+					ch.y = c.attribute("y").as_float();
+					ch.w = c.attribute("width").as_float();
+					ch.h = c.attribute("height").as_float();
+					out.chars.push_back(ch);
 				}
-#ifdef _DEBUG
-				Logging::writeLog("[Fnt] [Debug] Loaded " + std::to_string(chars.size()) + " characters.");
-#endif
 			}
 			else
 			{
-				Logging::writeLog("[FNT] [Warning] " + file + " doesn't have a chars node.");
-				return;
+				log.push_back("[FNT] [Warning] " + file + " doesn't have a chars node.");
+				return false;
 			}
-			std::sort(chars.begin(), chars.end());
 
 			n = doc.child("font").child("kernings");
 			if (n != NULL)
 			{
-				int loaded = 0;
 				for (pugi::xml_node c : n)
 				{
-					FntChar* cha = GetCharPtr(c.attribute("first").as_int());
+					FntCacheKerning k;
+					k.first = c.attribute("first").as_uint();
+					k.second = c.attribute("second").as_int();
+					k.amount = c.attribute("amount").as_int();
+					out.kernings.push_back(k);
+				}
+				out.hasKernings = true;
+			}
+			return true;
+		}
 
-					if (!cha)
-					{
-						Logging::writeLog("[FNT] [Kernings] [Warning] " + std::string(c.attribute("first").as_string()) + " doesn't exist!");
-						continue;
-					}
+		/**
+		 * \brief Fills this font (and loads its texture) from parsed or cached data
+		 * \param data The data
+		 * \param folder The folder the font is in
+		 */
+		void Build(const FntData& data, std::string folder)
+		{
+			name = data.name;
+			ogSize = data.ogSize;
+			texture = OpenGL::Texture::createWithImage(folder + "/" + data.page);
 
-					Kerning k;
-					k.with = c.attribute("second").as_int();
-					k.amount = c.attribute("amount").as_int();
-					cha->kernings.push_back(k);
-					loaded++;
+			chars.clear();
+			chars.reserve(data.chars.size());
+			for (const FntCacheChar& c : data.chars)
+			{
+				FntChar ch;
+				ch.xAdvance = c.xAdvance;
+				ch.id = c.id;
+				ch.dst = { c.x, c.y, c.w, c.h };
+				ch.src = { c.x / texture->width, c.y / texture->height, c.w / texture->width, c.h / texture->height };
+				chars.push_back(ch);
+			}
+#ifdef _DEBUG
+			Logging::writeLog("[Fnt] [Debug] Loaded " + std::to_string(chars.size()) + " characters.");
+#endif
+			std::sort(chars.begin(), chars.end());
+			BuildLookup();
+
+			hasKernings = data.hasKernings;
+			kerningPairs.clear();
+			kerningPairs.reserve(data.kernings.size());
+			int loaded = 0;
+			for (const FntCacheKerning& k : data.kernings)
+			{
+				FntChar* cha = const_cast<FntChar*>(FindChar(k.first));
+
+				if (!cha)
+				{
+					Logging::writeLog("[FNT] [Kernings] [Warning] " + std::to_string(k.first) + " doesn't exist!");
+					continue;
 				}
-				hasKernings = true;
-				#ifdef _DEBUG
-				Logging::writeLog("[Fnt] [Debug] Loaded " + std::to_string(loaded) + " kernings.");
-				#endif
+
+				Kerning kerning;
+				kerning.with = k.second;
+				kerning.amount = k.amount;
+				cha->kernings.push_back(kerning);
+				kerningPairs.emplace(KerningKey(cha->id, kerning.with), kerning.amount);
+				loaded++;
 			}
-			else
+#ifdef _DEBUG
+			if (hasKernings)
+				Logging::writeLog("[Fnt] [Debug] Loaded " + std::to_string(loaded) + " kernings.");
+#endif
+		}
+
+	private:
+		bool sdfFailed = false;
+
+		/**
+		 * \brief Writes out a load's log, and builds the font if it loaded (on the GL thread)
+		 */
+		void Finish(std::string folder, const FntLoad& load)
+		{
+			for (const std::string& line : load.log)
+				Logging::writeLog(line);
+			if (!load.ok)
+				return;
+
+			Build(load.data, folder);
+			if (buildSdf)
+				EnsureSdf();
+
+			if (!hasKernings)
 			{
-				Logging::writeLog("[FNT] [Warning] " + file + " doesn't have a kernings node.");
+				Logging::writeLog("[FNT] [Warning] " + fontFile + " doesn't have a kernings node.");
 				return;
 			}
-			
+
 			Logging::writeLog("[Fnt] Loaded font " + name + "x" + std::to_string(ogSize));
 		}
+
+		static const FntChar& MissingChar()
+		{
+			static const FntChar missing;
+			return missing;
+		}
+
+		static std::array<int, 256> MakeEmptyIndex()
+		{
+			std::array<int, 256> index;
+			index.fill(-1);
+			return index;
+		}
 	};
 }
 
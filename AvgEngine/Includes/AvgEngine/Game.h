@@ -12,6 +12,8 @@
 #include <AvgEngine/Debug/Console.h>
 #include <AvgEngine/EventManager.h>
 #include <AvgEngine/Base/Text.h>
+#include <AvgEngine/Render/TextureLoader.h>
+#include <AvgEngine/Render/TextureCache.h>
 #include <mutex>
 
 namespace AvgEngine
@@ -70,7 +72,7 @@ namespace AvgEngine
 			console.registerEvents(eManager);
 
 			// create font cache
-			Fnt::Fnt::fonts = new std::vector<Fnt::Fnt*>();
+			Fnt::Fnt::fonts = new std::unordered_map<std::string, Fnt::Fnt*>();
 
 		}
 
@@ -80,7 +82,7 @@ namespace AvgEngine
 			if (CurrentMenu)
 			{
 				CurrentMenu->camera.resize(Render::Display::width, Render::Display::height);
-				Render::Display::defaultShader->setProject(CurrentMenu->camera.projection);
+				Render::Display::SetProject(CurrentMenu->camera.projection);
 			}
 			Event(Events::Event(Events::EventType::Event_Resize));
 		}
@@ -126,11 +128,19 @@ namespace AvgEngine
 			eManager.Clear();
 			if (lastMenu != NULL)
 			{
+				// anything the old menu was still loading won't be needed
+				if (Render::TextureLoader::instance)
+					Render::TextureLoader::instance->CancelOwner(lastMenu.get());
 				lastMenu->tween.Clear();
 				lastMenu.reset();
+#ifdef _DEBUG
+				// anything still referenced here is being kept alive past its menu
+				if (Render::TextureCache::instance)
+					Render::TextureCache::instance->LogReport("After switching menus");
+#endif
 			}
 			CurrentMenu->load();
-			Render::Display::defaultShader->setProject(CurrentMenu->camera.projection);
+			Render::Display::SetProject(CurrentMenu->camera.projection);
 		}
 
 		virtual void update()
@@ -172,8 +182,20 @@ namespace AvgEngine
 					eventMutex.unlock();
 				}
 			}
+			// give any fonts that finished preloading their textures
+			Fnt::Fnt::FinishPreloads();
+
+			// upload whatever textures finished decoding
+			if (Render::TextureLoader::instance)
+				Render::TextureLoader::instance->Update();
+
+			// one buffer write gives every shader the time
+			Render::Display::SetTime(static_cast<float>(glfwGetTime()));
+
 			if (CurrentMenu != NULL)
 				CurrentMenu->draw();
+
+			OpenGL::StateCache::EndFrame();
 		}
 
 		virtual void QueueEvent(Events::Event e)
@@ -0,0 +1,1207 @@
+/*
+	Copyright 2021-2023 AvgEngine - Kade
+
+	Use of this source code without explict permission from owner is strictly prohibited.
+*/
+
+#include <AvgEngine/Render/BlockCompression.h>
+#include <AvgEngine/Render/Mipmaps.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+
+using namespace AvgEngine::Render;
+
+#ifndef BLOCKCOMPRESSION_CPP
+#define BLOCKCOMPRESSION_CPP
+
+namespace
+{
+	// BC7 partitions for two subsets, bit i set means pixel i is in subset 1
+	const uint16_t bc7Partitions2[64] = {
+		0xCCCC, 0x8888, 0xEEEE, 0xECC8, 0xC880, 0xFEEC, 0xFEC8, 0xEC80, 0xC800, 0xFFEC, 0xFE80, 0xE800, 0xFFE8, 0xFF00, 0xFFF0, 0xF000,
+		0xF710, 0x008E, 0x7100, 0x08CE, 0x008C, 0x7310, 0x3100, 0x8CCE, 0x088C, 0x3110, 0x6666, 0x366C, 0x17E8, 0x0FF0, 0x718E, 0x399C,
+		0xAAAA, 0xF0F0, 0x5A5A, 0x33CC, 0x3C3C, 0x55AA, 0x9696, 0xA55A, 0x73CE, 0x13C8, 0x324C, 0x3BDC, 0x6996, 0xC33C, 0x9966, 0x0660,
+		0x0272, 0x04E4, 0x4E40, 0x2720, 0xC936, 0x936C, 0x39C6, 0x639C, 0x9336, 0x9CC6, 0x817E, 0xE718, 0xCCF0, 0x0FCC, 0x7744, 0xEE22
+	};
+
+	// BC7 partitions for three subsets, two bits a pixel (pixel 0 in the lowest bits)
+	const uint32_t bc7Partitions3[64] = {
+		0xAA685050, 0x6A5A5040, 0x5A5A4200, 0x5450A0A8, 0xA5A50000, 0xA0A05050, 0x5555A0A0, 0x5A5A5050,
+		0xAA550000, 0xAA555500, 0xAAAA5500, 0x90909090, 0x94949494, 0xA4A4A4A4, 0xA9A59450, 0x2A0A4250,
+		0xA5945040, 0x0A425054, 0xA5A5A500, 0x55A0A0A0, 0xA8A85454, 0x6A6A4040, 0xA4A45000, 0x1A1A0500,
+		0x0050A4A4, 0xAAA59090, 0x14696914, 0x69691400, 0xA08585A0, 0xAA821414, 0x50A4A450, 0x6A5A0200,
+		0xA9A58000, 0x5090A0A8, 0xA8A09050, 0x24242424, 0x00AA5500, 0x24924924, 0x24499224, 0x50A50A50,
+		0x500AA550, 0xAAAA4444, 0x66660000, 0xA5A0A5A0, 0x50A050A0, 0x69286928, 0x44AAAA44, 0x66666600,
+		0xAA444444, 0x54A854A8, 0x95809580, 0x96969600, 0xA85454A8, 0x80959580, 0xAA141414, 0x96960000,
+		0xAAAA1414, 0xA05050A0, 0xA0A5A5A0, 0x96000000, 0x40804080, 0xA9A8A9A8, 0xAAAAAA44, 0x2A4A5254
+	};
+
+	// the pixel whose index drops its top bit, for the second subset (of 2) and the second and third (of 3)
+	const uint8_t bc7Anchor2[64] = {
+		15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,
+		15, 2, 8, 2, 2, 8, 8, 15, 2, 8, 2, 2, 8, 8, 2, 2,
+		15, 15, 6, 8, 2, 8, 15, 15, 2, 8, 2, 2, 2, 15, 15, 6,
+		6, 2, 6, 8, 15, 15, 2, 2, 15, 15, 15, 15, 15, 2, 2, 15
+	};
+	const uint8_t bc7Anchor3a[64] = {
+		3, 3, 15, 15, 8, 3, 15, 15, 8, 8, 6, 6, 6, 5, 3, 3,
+		3, 3, 8, 15, 3, 3, 6, 10, 5, 8, 8, 6, 8, 5, 15, 15,
+		8, 15, 3, 5, 6, 10, 8, 15, 15, 3, 15, 5, 15, 15, 15, 15,
+		3, 15, 5, 5, 5, 8, 5, 10, 5, 10, 8, 13, 15, 12, 3, 3
+	};
+	const uint8_t bc7Anchor3b[64] = {
+		15, 8, 8, 3, 15, 15, 3, 8, 15, 15, 15, 15, 15, 15, 15, 8,
+		15, 8, 15, 3, 15, 8, 15, 8, 3, 15, 6, 10, 15, 15, 10, 8,
+		15, 3, 15, 10, 10, 8, 9, 10, 6, 15, 8, 15, 3, 6, 6, 8,
+		15, 3, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 3, 15, 15, 8
+	};
+
+	const uint8_t bc7Weights2[4] = { 0, 21, 43, 64 };
+	const uint8_t bc7Weights3[8] = { 0, 9, 18, 27, 37, 46, 55, 64 };
+	const uint8_t bc7Weights4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+	struct BC7Mode
+	{
+		int subsets, partitionBits, rotationBits, indexSelectionBits, colourBits, alphaBits, endpointPBits, sharedPBits, indexBits, index2Bits;
+	};
+
+	const BC7Mode bc7Modes[8] = {
+		{ 3, 4, 0, 0, 4, 0, 1, 0, 3, 0 },
+		{ 2, 6, 0, 0, 6, 0, 0, 1, 3, 0 },
+		{ 3, 6, 0, 0, 5, 0, 0, 0, 2, 0 },
+		{ 2, 6, 0, 0, 7, 0, 1, 0, 2, 0 },
+		{ 1, 0, 2, 1, 5, 6, 0, 0, 2, 3 },
+		{ 1, 0, 2, 0, 7, 8, 0, 0, 2, 2 },
+		{ 1, 0, 0, 0, 7, 7, 1, 0, 4, 0 },
+		{ 2, 6, 0, 0, 5, 5, 1, 0, 2, 0 }
+	};
+
+	const int etcModifiers[8][2] = { { 2, 8 }, { 5, 17 }, { 9, 29 }, { 13, 42 }, { 18, 60 }, { 24, 80 }, { 33, 106 }, { 47, 183 } };
+	const int etcDistances[8] = { 3, 6, 11, 16, 23, 32, 41, 64 };
+
+	const int eacModifiers[16][8] = {
+		{ -3, -6, -9, -15, 2, 5, 8, 14 }, { -3, -7, -10, -13, 2, 6, 9, 12 }, { -2, -5, -8, -13, 1, 4, 7, 12 }, { -2, -4, -6, -13, 1, 3, 5, 12 },
+		{ -3, -6, -8, -12, 2, 5, 7, 11 }, { -3, -7, -9, -11, 2, 6, 8, 10 }, { -4, -7, -8, -11, 3, 6, 7, 10 }, { -3, -5, -8, -11, 2, 4, 7, 10 },
+		{ -2, -6, -8, -10, 1, 5, 7, 9 }, { -2, -5, -8, -10, 1, 4, 7, 9 }, { -2, -4, -8, -10, 1, 3, 7, 9 }, { -2, -5, -7, -10, 1, 4, 6, 9 },
+		{ -3, -4, -7, -10, 2, 3, 6, 9 }, { -1, -2, -3, -10, 0, 1, 2, 9 }, { -4, -6, -8, -9, 3, 5, 7, 8 }, { -3, -5, -7, -9, 2, 4, 6, 8 }
+	};
+
+	/**
+	 * \brief Reads a 128 bit block a few bits at a time, lowest bit first
+	 */
+	struct BitReader
+	{
+		const unsigned char* data;
+		int position = 0;
+
+		int Read(int count)
+		{
+			int value = 0;
+			for (int i = 0; i < count; i++, position++)
+				value |= ((data[position >> 3] >> (position & 7)) & 1) << i;
+			return value;
+		}
+	};
+
+	/**
+	 * \brief Writes a 128 bit block a few bits at a time, lowest bit first
+	 */
+	struct BitWriter
+	{
+		unsigned char* data;
+		int position = 0;
+
+		void Write(int value, int count)
+		{
+			for (int i = 0; i < count; i++, position++)
+				data[position >> 3] |= static_cast<unsigned char>(((value >> i) & 1) << (position & 7));
+		}
+	};
+
+	uint64_t BigEndian64(const unsigned char* p)
+	{
+		uint64_t v = 0;
+		for (int i = 0; i < 8; i++)
+			v = (v << 8) | p[i];
+		return v;
+	}
+
+	int Bits(uint64_t v, int high, int low)
+	{
+		return static_cast<int>((v >> low) & ((1ull << (high - low + 1)) - 1));
+	}
+
+	int Clamp255(int v)
+	{
+		return v < 0 ? 0 : (v > 255 ? 255 : v);
+	}
+
+	uint32_t Read32(const std::vector<unsigned char>& file, size_t offset)
+	{
+		return file[offset] | (file[offset + 1] << 8) | (file[offset + 2] << 16) | (static_cast<uint32_t>(file[offset + 3]) << 24);
+	}
+
+	uint64_t Read64(const std::vector<unsigned char>& file, size_t offset)
+	{
+		return Read32(file, offset) | (static_cast<uint64_t>(Read32(file, offset + 4)) << 32);
+	}
+
+	void Write32(std::vector<unsigned char>& file, size_t offset, uint32_t v)
+	{
+		for (int i = 0; i < 4; i++)
+			file[offset + i] = static_cast<unsigned char>(v >> (i * 8));
+	}
+
+	uint32_t FourCC(const char* code)
+	{
+		return code[0] | (code[1] << 8) | (code[2] << 16) | (code[3] << 24);
+	}
+
+	/**
+	 * \brief The direction colours in a block vary the most along (power iteration on the covariance)
+	 */
+	void PrincipalAxis(const float (*pixels)[4], int count, int channels, float* mean, float* axis)
+	{
+		for (int c = 0; c < channels; c++)
+		{
+			mean[c] = 0;
+			for (int i = 0; i < count; i++)
+				mean[c] += pixels[i][c];
+			mean[c] /= static_cast<float>(count);
+		}
+
+		float cov[4][4] = {};
+		for (int i = 0; i < count; i++)
+			for (int a = 0; a < channels; a++)
+				for (int b = 0; b < channels; b++)
+					cov[a][b] += (pixels[i][a] - mean[a]) * (pixels[i][b] - mean[b]);
+
+		float v[4] = { 1, 1, 1, 1 };
+		for (int iteration = 0; iteration < 8; iteration++)
+		{
+			float next[4] = {};
+			float length = 0;
+			for (int a = 0; a < channels; a++)
+			{
+				for (int b = 0; b < channels; b++)
+					next[a] += cov[a][b] * v[b];
+				length = std::max(length, std::abs(next[a]));
+			}
+			if (length == 0)
+				break;
+			for (int a = 0; a < channels; a++)
+				v[a] = next[a] / length;
+		}
+
+		float length = 0;
+		for (int c = 0; c < channels; c++)
+			length += v[c] * v[c];
+		length = std::sqrt(length);
+		for (int c = 0; c < channels; c++)
+			axis[c] = length > 0 ? v[c] / length : 0;
+	}
+
+	uint16_t To565(float r, float g, float b)
+	{
+		int ri = std::clamp(static_cast<int>(r * 31.0f / 255.0f + 0.5f), 0, 31);
+		int gi = std::clamp(static_cast<int>(g * 63.0f / 255.0f + 0.5f), 0, 63);
+		int bi = std::clamp(static_cast<int>(b * 31.0f / 255.0f + 0.5f), 0, 31);
+		return static_cast<uint16_t>((ri << 11) | (gi << 5) | bi);
+	}
+
+	void From565(uint16_t c, int* out)
+	{
+		int r = (c >> 11) & 31;
+		int g = (c >> 5) & 63;
+		int b = c & 31;
+		out[0] = (r << 3) | (r >> 2);
+		out[1] = (g << 2) | (g >> 4);
+		out[2] = (b << 3) | (b >> 2);
+	}
+
+	/**
+	 * \brief The four colours a BC1 block can pick from
+	 */
+	void BC1Palette(uint16_t c0, uint16_t c1, bool threeColour, int (*palette)[4])
+	{
+		From565(c0, palette[0]);
+		From565(c1, palette[1]);
+		palette[0][3] = 255;
+		palette[1][3] = 255;
+		for (int c = 0; c < 3; c++)
+		{
+			if (threeColour)
+			{
+				palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+				palette[3][c] = 0;
+			}
+			else
+			{
+				palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+				palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+			}
+		}
+		palette[2][3] = 255;
+		palette[3][3] = threeColour ? 0 : 255;
+	}
+}
+
+const char* BlockCompression::FormatName(BlockFormat format)
+{
+	switch (format)
+	{
+	case BlockFormat::BC1:
+		return "BC1";
+	case BlockFormat::BC3:
+		return "BC3";
+	case BlockFormat::BC7:
+		return "BC7";
+	case BlockFormat::ETC2_RGB:
+		return "ETC2 RGB";
+	case BlockFormat::ETC2_RGBA:
+		return "ETC2 RGBA";
+	default:
+		return "None";
+	}
+}
+
+size_t BlockCompression::BlockBytes(BlockFormat format)
+{
+	switch (format)
+	{
+	case BlockFormat::BC1:
+	case BlockFormat::ETC2_RGB:
+		return 8;
+	case BlockFormat::BC3:
+	case BlockFormat::BC7:
+	case BlockFormat::ETC2_RGBA:
+		return 16;
+	default:
+		return 0;
+	}
+}
+
+size_t BlockCompression::LevelBytes(BlockFormat format, int w, int h)
+{
+	return static_cast<size_t>((w + 3) / 4) * static_cast<size_t>((h + 3) / 4) * BlockBytes(format);
+}
+
+bool BlockCompression::IsContainer(const std::string& filePath)
+{
+	size_t dot = filePath.find_last_of('.');
+	if (dot == std::string::npos)
+		return false;
+	std::string extension = filePath.substr(dot + 1);
+	std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+	return extension == "dds" || extension == "ktx2";
+}
+
+bool BlockCompression::Read(const std::string& filePath, CompressedImage& out, std::string& error)
+{
+	std::ifstream stream(filePath, std::ios::binary);
+	if (!stream)
+	{
+		error = "couldn't open the file";
+		return false;
+	}
+	std::vector<unsigned char> file((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+
+	if (file.size() >= 4 && Read32(file, 0) == FourCC("DDS "))
+		return ReadDDS(file, out, error);
+	static const unsigned char ktx2[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+	if (file.size() >= 12 && memcmp(file.data(), ktx2, 12) == 0)
+		return ReadKTX2(file, out, error);
+
+	error = "it isn't a DDS or KTX2 file";
+	return false;
+}
+
+bool BlockCompression::ReadDDS(const std::vector<unsigned char>& file, CompressedImage& out, std::string& error)
+{
+	if (file.size() < 128 || Read32(file, 4) != 124)
+	{
+		error = "the DDS header is cut off";
+		return false;
+	}
+
+	const uint32_t mipMapCountFlag = 0x20000;
+	uint32_t flags = Read32(file, 8);
+	int height = static_cast<int>(Read32(file, 12));
+	int width = static_cast<int>(Read32(file, 16));
+	uint32_t mipCount = (flags & mipMapCountFlag) ? std::max<uint32_t>(Read32(file, 28), 1) : 1;
+	uint32_t fourCC = Read32(file, 84);
+
+	size_t offset = 128;
+	BlockFormat format = BlockFormat::None;
+	if (fourCC == FourCC("DXT1"))
+		format = BlockFormat::BC1;
+	else if (fourCC == FourCC("DXT5"))
+		format = BlockFormat::BC3;
+	else if (fourCC == FourCC("DX10"))
+	{
+		if (file.size() < 148)
+		{
+			error = "the DX10 header is cut off";
+			return false;
+		}
+		// sRGB variants are read as the plain ones, nothing here is gamma aware
+		switch (Read32(file, 128))
+		{
+		case 71:
+		case 72:
+			format = BlockFormat::BC1;
+			break;
+		case 77:
+		case 78:
+			format = BlockFormat::BC3;
+			break;
+		case 98:
+		case 99:
+			format = BlockFormat::BC7;
+			break;
+		}
+		offset = 148;
+	}
+
+	if (format == BlockFormat::None)
+	{
+		error = "the DDS isn't BC1, BC3 or BC7";
+		return false;
+	}
+	if (width <= 0 || height <= 0)
+	{
+		error = "the DDS has no size";
+		return false;
+	}
+	// a count past the 1x1 level would shift the sizes to nothing (and past 31 is undefined)
+	mipCount = std::min(mipCount, static_cast<uint32_t>(Mipmaps::LevelCount(width, height)));
+
+	out.format = format;
+	out.width = width;
+	out.height = height;
+	out.levels.clear();
+	for (uint32_t i = 0; i < mipCount; i++)
+	{
+		CompressedLevel level;
+		level.width = std::max(width >> i, 1);
+		level.height = std::max(height >> i, 1);
+		size_t size = LevelBytes(format, level.width, level.height);
+		if (offset + size > file.size())
+		{
+			// keep whatever levels fit, a texture with fewer mips is still a texture
+			if (i == 0)
+			{
+				error = "the DDS data is cut off";
+				return false;
+			}
+			break;
+		}
+		level.data.assign(file.begin() + offset, file.begin() + offset + size);
+		offset += size;
+		out.levels.push_back(std::move(level));
+	}
+	return true;
+}
+
+bool BlockCompression::ReadKTX2(const std::vector<unsigned char>& file, CompressedImage& out, std::string& error)
+{
+	if (file.size() < 80)
+	{
+		error = "the KTX2 header is cut off";
+		return false;
+	}
+
+	uint32_t vkFormat = Read32(file, 12);
+	int width = static_cast<int>(Read32(file, 20));
+	int height = static_cast<int>(Read32(file, 24));
+	uint32_t depth = Read32(file, 28);
+	uint32_t layers = Read32(file, 32);
+	uint32_t faces = Read32(file, 36);
+	uint32_t levelCount = std::max<uint32_t>(Read32(file, 40), 1);
+	uint32_t supercompression = Read32(file, 44);
+
+	if (supercompression != 0)
+	{
+		error = "supercompressed KTX2 files (Basis, zstd) aren't supported";
+		return false;
+	}
+	if (depth > 1 || layers > 1 || faces != 1)
+	{
+		error = "only plain 2D KTX2 textures are supported";
+		return false;
+	}
+
+	// sRGB variants are read as the plain ones, nothing here is gamma aware
+	BlockFormat format = BlockFormat::None;
+	switch (vkFormat)
+	{
+	case 131:
+	case 132:
+	case 133:
+	case 134:
+		format = BlockFormat::BC1;
+		break;
+	case 137:
+	case 138:
+		format = BlockFormat::BC3;
+		break;
+	case 145:
+	case 146:
+		format = BlockFormat::BC7;
+		break;
+	case 147:
+	case 148:
+		format = BlockFormat::ETC2_RGB;
+		break;
+	case 151:
+	case 152:
+		format = BlockFormat::ETC2_RGBA;
+		break;
+	}
+
+	if (format == BlockFormat::None)
+	{
+		error = "the KTX2's format (" + std::to_string(vkFormat) + ") isn't BC1, BC3, BC7 or ETC2";
+		return false;
+	}
+	if (width <= 0 || height <= 0)
+	{
+		error = "the KTX2 has no size";
+		return false;
+	}
+	// extra levels past 1x1 are ignored, same as for DDS
+	levelCount = std::min(levelCount, static_cast<uint32_t>(Mipmaps::LevelCount(width, height)));
+	if (file.size() < 80 + static_cast<size_t>(levelCount) * 24)
+	{
+		error = "the KTX2 level index is cut off";
+		return false;
+	}
+
+	out.format = format;
+	out.width = width;
+	out.height = height;
+	out.levels.clear();
+	for (uint32_t i = 0; i < levelCount; i++)
+	{
+		uint64_t offset = Read64(file, 80 + i * 24);
+		uint64_t length = Read64(file, 80 + i * 24 + 8);
+
+		CompressedLevel level;
+		level.width = std::max(width >> i, 1);
+		level.height = std::max(height >> i, 1);
+		if (length != LevelBytes(format, level.width, level.height) || offset + length > file.size())
+		{
+			error = "level " + std::to_string(i) + " of the KTX2 is the wrong size";
+			return false;
+		}
+		level.data.assign(file.begin() + offset, file.begin() + offset + length);
+		out.levels.push_back(std::move(level));
+	}
+	return true;
+}
+
+bool BlockCompression::WriteDDS(const std::string& filePath, const CompressedImage& image, std::string& error)
+{
+	if (image.levels.size() == 0 || (image.format != BlockFormat::BC1 && image.format != BlockFormat::BC3 && image.format != BlockFormat::BC7))
+	{
+		error = "only BC1, BC3 and BC7 images can be written to DDS";
+		return false;
+	}
+
+	bool dx10 = image.format == BlockFormat::BC7;
+	std::vector<unsigned char> header(dx10 ? 148 : 128, 0);
+	Write32(header, 0, FourCC("DDS "));
+	Write32(header, 4, 124);
+	// caps, height, width, pixel format, linear size (and the mip count when there's more than one)
+	uint32_t flags = 0x1 | 0x2 | 0x4 | 0x1000 | 0x80000;
+	if (image.levels.size() > 1)
+		flags |= 0x20000;
+	Write32(header, 8, flags);
+	Write32(header, 12, image.height);
+	Write32(header, 16, image.width);
+	Write32(header, 20, static_cast<uint32_t>(image.levels[0].data.size()));
+	Write32(header, 28, static_cast<uint32_t>(image.levels.size()));
+	Write32(header, 76, 32);
+	Write32(header, 80, 0x4);
+	Write32(header, 84, dx10 ? FourCC("DX10") : FourCC(image.format == BlockFormat::BC1 ? "DXT1" : "DXT5"));
+	// texture, plus complex and mipmap when there are mips
+	Write32(header, 108, image.levels.size() > 1 ? 0x1000 | 0x8 | 0x400000 : 0x1000);
+	if (dx10)
+	{
+		Write32(header, 128, 98);
+		// a 2D texture, one of it
+		Write32(header, 132, 3);
+		Write32(header, 140, 1);
+	}
+
+	std::ofstream stream(filePath, std::ios::binary);
+	if (!stream)
+	{
+		error = "couldn't open the file for writing";
+		return false;
+	}
+	stream.write(reinterpret_cast<const char*>(header.data()), header.size());
+	for (const CompressedLevel& level : image.levels)
+		stream.write(reinterpret_cast<const char*>(level.data.data()), level.data.size());
+	if (!stream)
+	{
+		error = "couldn't write the file";
+		return false;
+	}
+	return true;
+}
+
+void BlockCompression::Decode(BlockFormat format, const CompressedLevel& level, unsigned char* out)
+{
+	size_t blockBytes = BlockBytes(format);
+	int blocksX = (level.width + 3) / 4;
+	int blocksY = (level.height + 3) / 4;
+	unsigned char pixels[64];
+
+	for (int by = 0; by < blocksY; by++)
+	{
+		for (int bx = 0; bx < blocksX; bx++)
+		{
+			DecodeBlock(format, level.data.data() + (static_cast<size_t>(by) * blocksX + bx) * blockBytes, pixels);
+
+			// edge blocks hang off the image, so only copy the part that's in it
+			int w = std::min(4, level.width - bx * 4);
+			int h = std::min(4, level.height - by * 4);
+			for (int y = 0; y < h; y++)
+				memcpy(out + ((static_cast<size_t>(by) * 4 + y) * level.width + bx * 4) * 4, pixels + y * 16, static_cast<size_t>(w) * 4);
+		}
+	}
+}
+
+bool BlockCompression::Encode(BlockFormat format, const unsigned char* rgba, int w, int h, CompressedLevel& out)
+{
+	if (format != BlockFormat::BC1 && format != BlockFormat::BC3 && format != BlockFormat::BC7)
+		return false;
+
+	size_t blockBytes = BlockBytes(format);
+	int blocksX = (w + 3) / 4;
+	int blocksY = (h + 3) / 4;
+	out.width = w;
+	out.height = h;
+	out.data.assign(LevelBytes(format, w, h), 0);
+
+	unsigned char pixels[64];
+	for (int by = 0; by < blocksY; by++)
+	{
+		for (int bx = 0; bx < blocksX; bx++)
+		{
+			// edge blocks repeat the last row and column, so the padding doesn't pull the endpoints around
+			for (int y = 0; y < 4; y++)
+			{
+				int sy = std::min(by * 4 + y, h - 1);
+				for (int x = 0; x < 4; x++)
+				{
+					int sx = std::min(bx * 4 + x, w - 1);
+					memcpy(pixels + (y * 4 + x) * 4, rgba + (static_cast<size_t>(sy) * w + sx) * 4, 4);
+				}
+			}
+			EncodeBlock(format, pixels, out.data.data() + (static_cast<size_t>(by) * blocksX + bx) * blockBytes);
+		}
+	}
+	return true;
+}
+
+void BlockCompression::DecodeBlock(BlockFormat format, const unsigned char* block, unsigned char* out)
+{
+	switch (format)
+	{
+	case BlockFormat::BC1:
+		DecodeBC1(block, out, true);
+		break;
+	case BlockFormat::BC3:
+		DecodeBC1(block + 8, out, false);
+		DecodeBC3Alpha(block, out);
+		break;
+	case BlockFormat::BC7:
+		DecodeBC7(block, out);
+		break;
+	case BlockFormat::ETC2_RGB:
+		DecodeETC2(block, out);
+		break;
+	case BlockFormat::ETC2_RGBA:
+		DecodeETC2(block + 8, out);
+		DecodeEAC(block, out);
+		break;
+	default:
+		memset(out, 0, 64);
+		break;
+	}
+}
+
+bool BlockCompression::EncodeBlock(BlockFormat format, const unsigned char* rgba, unsigned char* block)
+{
+	switch (format)
+	{
+	case BlockFormat::BC1:
+		EncodeBC1(rgba, block, true);
+		return true;
+	case BlockFormat::BC3:
+		EncodeBC3Alpha(rgba, block);
+		EncodeBC1(rgba, block + 8, false);
+		return true;
+	case BlockFormat::BC7:
+		EncodeBC7(rgba, block);
+		return true;
+	default:
+		return false;
+	}
+}
+
+void BlockCompression::DecodeBC1(const unsigned char* block, unsigned char* out, bool threeColour)
+{
+	uint16_t c0 = static_cast<uint16_t>(block[0] | (block[1] << 8));
+	uint16_t c1 = static_cast<uint16_t>(block[2] | (block[3] << 8));
+	uint32_t indices = block[4] | (block[5] << 8) | (block[6] << 16) | (static_cast<uint32_t>(block[7]) << 24);
+
+	int palette[4][4];
+	// BC3's colour block is always four colours
+	BC1Palette(c0, c1, threeColour && c0 <= c1, palette);
+
+	for (int i = 0; i < 16; i++)
+	{
+		const int* p = palette[(indices >> (i * 2)) & 3];
+		for (int c = 0; c < 4; c++)
+			out[i * 4 + c] = static_cast<unsigned char>(p[c]);
+	}
+}
+
+void BlockCompression::DecodeBC3Alpha(const unsigned char* block, unsigned char* out)
+{
+	int a0 = block[0];
+	int a1 = block[1];
+	uint64_t indices = 0;
+	for (int i = 0; i < 6; i++)
+		indices |= static_cast<uint64_t>(block[2 + i]) << (i * 8);
+
+	int palette[8] = { a0, a1 };
+	if (a0 > a1)
+	{
+		for (int i = 1; i < 7; i++)
+			palette[i + 1] = ((7 - i) * a0 + i * a1) / 7;
+	}
+	else
+	{
+		for (int i = 1; i < 5; i++)
+			palette[i + 1] = ((5 - i) * a0 + i * a1) / 5;
+		palette[6] = 0;
+		palette[7] = 255;
+	}
+
+	for (int i = 0; i < 16; i++)
+		out[i * 4 + 3] = static_cast<unsigned char>(palette[(indices >> (i * 3)) & 7]);
+}
+
+void BlockCompression::DecodeBC7(const unsigned char* block, unsigned char* out)
+{
+	int mode = 0;
+	while (mode < 8 && ((block[0] >> mode) & 1) == 0)
+		mode++;
+	// reserved, decodes to transparent black
+	if (mode == 8)
+	{
+		memset(out, 0, 64);
+		return;
+	}
+
+	const BC7Mode& m = bc7Modes[mode];
+	BitReader bits{ block };
+	bits.Read(mode + 1);
+	int partition = bits.Read(m.partitionBits);
+	int rotation = bits.Read(m.rotationBits);
+	int indexSelection = bits.Read(m.indexSelectionBits);
+
+	// [subset * 2 + end][channel]
+	int endpoints[6][4] = {};
+	int endpointCount = m.subsets * 2;
+	for (int c = 0; c < 3; c++)
+		for (int e = 0; e < endpointCount; e++)
+			endpoints[e][c] = bits.Read(m.colourBits);
+	for (int e = 0; e < endpointCount; e++)
+		endpoints[e][3] = m.alphaBits != 0 ? bits.Read(m.alphaBits) : 255;
+
+	int colourBits = m.colourBits;
+	int alphaBits = m.alphaBits;
+	if (m.endpointPBits || m.sharedPBits)
+	{
+		int pBits[6];
+		if (m.endpointPBits)
+		{
+			for (int e = 0; e < endpointCount; e++)
+				pBits[e] = bits.Read(1);
+		}
+		else
+		{
+			for (int s = 0; s < m.subsets; s++)
+				pBits[s * 2] = pBits[s * 2 + 1] = bits.Read(1);
+		}
+		for (int e = 0; e < endpointCount; e++)
+		{
+			for (int c = 0; c < 3; c++)
+				endpoints[e][c] = (endpoints[e][c] << 1) | pBits[e];
+			if (alphaBits != 0)
+				endpoints[e][3] = (endpoints[e][3] << 1) | pBits[e];
+		}
+		colourBits++;
+		if (alphaBits != 0)
+			alphaBits++;
+	}
+
+	// stretch to 8 bits, repeating the top bits into the bottom
+	for (int e = 0; e < endpointCount; e++)
+	{
+		for (int c = 0; c < 3; c++)
+			endpoints[e][c] = (endpoints[e][c] << (8 - colourBits)) | (endpoints[e][c] >> (2 * colourBits - 8));
+		if (alphaBits != 0)
+			endpoints[e][3] = (endpoints[e][3] << (8 - alphaBits)) | (endpoints[e][3] >> (2 * alphaBits - 8));
+	}
+
+	int subsetOf[16];
+	for (int i = 0; i < 16; i++)
+	{
+		if (m.subsets == 2)
+			subsetOf[i] = (bc7Partitions2[partition] >> i) & 1;
+		else if (m.subsets == 3)
+			subsetOf[i] = (bc7Partitions3[partition] >> (i * 2)) & 3;
+		else
+			subsetOf[i] = 0;
+	}
+
+	auto isAnchor = [&](int i) {
+		if (i == 0)
+			return true;
+		if (m.subsets == 2)
+			return i == bc7Anchor2[partition];
+		if (m.subsets == 3)
+			return i == bc7Anchor3a[partition] || i == bc7Anchor3b[partition];
+		return false;
+	};
+
+	int indices[16];
+	int indices2[16] = {};
+	for (int i = 0; i < 16; i++)
+		indices[i] = bits.Read(isAnchor(i) ? m.indexBits - 1 : m.indexBits);
+	if (m.index2Bits != 0)
+		for (int i = 0; i < 16; i++)
+			indices2[i] = bits.Read(i == 0 ? m.index2Bits - 1 : m.index2Bits);
+
+	auto weights = [](int bitCount) {
+		return bitCount == 2 ? bc7Weights2 : (bitCount == 3 ? bc7Weights3 : bc7Weights4);
+	};
+
+	for (int i = 0; i < 16; i++)
+	{
+		const int* e0 = endpoints[subsetOf[i] * 2];
+		const int* e1 = endpoints[subsetOf[i] * 2 + 1];
+
+		int colourWeight;
+		int alphaWeight;
+		if (m.index2Bits == 0)
+		{
+			colourWeight = alphaWeight = weights(m.indexBits)[indices[i]];
+		}
+		else if (indexSelection == 0)
+		{
+			colourWeight = weights(m.indexBits)[indices[i]];
+			alphaWeight = weights(m.index2Bits)[indices2[i]];
+		}
+		else
+		{
+			colourWeight = weights(m.index2Bits)[indices2[i]];
+			alphaWeight = weights(m.indexBits)[indices[i]];
+		}
+
+		int p[4];
+		for (int c = 0; c < 3; c++)
+			p[c] = ((64 - colourWeight) * e0[c] + colourWeight * e1[c] + 32) >> 6;
+		p[3] = ((64 - alphaWeight) * e0[3] + alphaWeight * e1[3] + 32) >> 6;
+
+		if (rotation != 0)
+			std::swap(p[3], p[rotation - 1]);
+
+		for (int c = 0; c < 4; c++)
+			out[i * 4 + c] = static_cast<unsigned char>(p[c]);
+	}
+}
+
+void BlockCompression::DecodeETC2(const unsigned char* block, unsigned char* out)
+{
+	uint64_t v = BigEndian64(block);
+	bool differential = Bits(v, 33, 33) != 0;
+	bool flip = Bits(v, 32, 32) != 0;
+
+	auto indexOf = [&](int x, int y) {
+		// indices go down columns
+		int i = x * 4 + y;
+		return (Bits(v, i + 16, i + 16) << 1) | Bits(v, i, i);
+	};
+	auto write = [&](int x, int y, int r, int g, int b) {
+		unsigned char* p = out + (y * 4 + x) * 4;
+		p[0] = static_cast<unsigned char>(Clamp255(r));
+		p[1] = static_cast<unsigned char>(Clamp255(g));
+		p[2] = static_cast<unsigned char>(Clamp255(b));
+		p[3] = 255;
+	};
+	auto expand4 = [](int c) { return c * 17; };
+
+	int base[2][3];
+	if (differential)
+	{
+		int r = Bits(v, 63, 59);
+		int g = Bits(v, 55, 51);
+		int b = Bits(v, 47, 43);
+		// the deltas are 3 bit signed
+		int dr = (Bits(v, 58, 56) ^ 4) - 4;
+		int dg = (Bits(v, 50, 48) ^ 4) - 4;
+		int db = (Bits(v, 42, 40) ^ 4) - 4;
+
+		if (r + dr < 0 || r + dr > 31)
+		{
+			// T mode
+			int c[2][3] = {
+				{ expand4((Bits(v, 60, 59) << 2) | Bits(v, 57, 56)), expand4(Bits(v, 55, 52)), expand4(Bits(v, 51, 48)) },
+				{ expand4(Bits(v, 47, 44)), expand4(Bits(v, 43, 40)), expand4(Bits(v, 39, 36)) }
+			};
+			int d = etcDistances[(Bits(v, 35, 34) << 1) | Bits(v, 32, 32)];
+			int paint[4][3];
+			for (int ch = 0; ch < 3; ch++)
+			{
+				paint[0][ch] = c[0][ch];
+				paint[1][ch] = c[1][ch] + d;
+				paint[2][ch] = c[1][ch];
+				paint[3][ch] = c[1][ch] - d;
+			}
+			for (int y = 0; y < 4; y++)
+				for (int x = 0; x < 4; x++)
+				{
+					const int* p = paint[indexOf(x, y)];
+					write(x, y, p[0], p[1], p[2]);
+				}
+			return;
+		}
+		if (g + dg < 0 || g + dg > 31)
+		{
+			// H mode
+			int c4[2][3] = {
+				{ Bits(v, 62, 59), (Bits(v, 58, 56) << 1) | Bits(v, 52, 52), (Bits(v, 51, 51) << 3) | Bits(v, 49, 47) },
+				{ Bits(v, 46, 43), Bits(v, 42, 39), Bits(v, 38, 35) }
+			};
+			int value0 = (c4[0][0] << 8) | (c4[0][1] << 4) | c4[0][2];
+			int value1 = (c4[1][0] << 8) | (c4[1][1] << 4) | c4[1][2];
+			int d = etcDistances[(Bits(v, 34, 34) << 2) | (Bits(v, 32, 32) << 1) | (value0 >= value1 ? 1 : 0)];
+			int paint[4][3];
+			for (int ch = 0; ch < 3; ch++)
+			{
+				paint[0][ch] = expand4(c4[0][ch]) + d;
+				paint[1][ch] = expand4(c4[0][ch]) - d;
+				paint[2][ch] = expand4(c4[1][ch]) + d;
+				paint[3][ch] = expand4(c4[1][ch]) - d;
+			}
+			for (int y = 0; y < 4; y++)
+				for (int x = 0; x < 4; x++)
+				{
+					const int* p = paint[indexOf(x, y)];
+					write(x, y, p[0], p[1], p[2]);
+				}
+			return;
+		}
+		if (b + db < 0 || b + db > 31)
+		{
+			// planar mode
+			auto expand6 = [](int c) { return (c << 2) | (c >> 4); };
+			auto expand7 = [](int c) { return (c << 1) | (c >> 6); };
+			int o[3] = { expand6(Bits(v, 62, 57)), expand7((Bits(v, 56, 56) << 6) | Bits(v, 54, 49)),
+				expand6((Bits(v, 48, 48) << 5) | (Bits(v, 44, 43) << 3) | Bits(v, 41, 39)) };
+			int hz[3] = { expand6((Bits(v, 38, 34) << 1) | Bits(v, 32, 32)), expand7(Bits(v, 31, 25)), expand6(Bits(v, 24, 19)) };
+			int vt[3] = { expand6(Bits(v, 18, 13)), expand7(Bits(v, 12, 6)), expand6(Bits(v, 5, 0)) };
+			for (int y = 0; y < 4; y++)
+				for (int x = 0; x < 4; x++)
+				{
+					int p[3];
+					for (int ch = 0; ch < 3; ch++)
+						p[ch] = (x * (hz[ch] - o[ch]) + y * (vt[ch] - o[ch]) + 4 * o[ch] + 2) >> 2;
+					write(x, y, p[0], p[1], p[2]);
+				}
+			return;
+		}
+
+		auto expand5 = [](int c) { return (c << 3) | (c >> 2); };
+		base[0][0] = expand5(r);
+		base[0][1] = expand5(g);
+		base[0][2] = expand5(b);
+		base[1][0] = expand5(r + dr);
+		base[1][1] = expand5(g + dg);
+		base[1][2] = expand5(b + db);
+	}
+	else
+	{
+		base[0][0] = expand4(Bits(v, 63, 60));
+		base[1][0] = expand4(Bits(v, 59, 56));
+		base[0][1] = expand4(Bits(v, 55, 52));
+		base[1][1] = expand4(Bits(v, 51, 48));
+		base[0][2] = expand4(Bits(v, 47, 44));
+		base[1][2] = expand4(Bits(v, 43, 40));
+	}
+
+	int table[2] = { Bits(v, 39, 37), Bits(v, 36, 34) };
+	for (int y = 0; y < 4; y++)
+	{
+		for (int x = 0; x < 4; x++)
+		{
+			int sub = flip ? (y >= 2 ? 1 : 0) : (x >= 2 ? 1 : 0);
+			int index = indexOf(x, y);
+			int modifier = etcModifiers[table[sub]][index & 1];
+			if (index & 2)
+				modifier = -modifier;
+			write(x, y, base[sub][0] + modifier, base[sub][1] + modifier, base[sub][2] + modifier);
+		}
+	}
+}
+
+void BlockCompression::DecodeEAC(const unsigned char* block, unsigned char* out)
+{
+	uint64_t v = BigEndian64(block);
+	int base = Bits(v, 63, 56);
+	int multiplier = Bits(v, 55, 52);
+	const int* modifiers = eacModifiers[Bits(v, 51, 48)];
+
+	for (int x = 0; x < 4; x++)
+	{
+		for (int y = 0; y < 4; y++)
+		{
+			int i = x * 4 + y;
+			int index = Bits(v, 47 - i * 3, 45 - i * 3);
+			out[(y * 4 + x) * 4 + 3] = static_cast<unsigned char>(Clamp255(base + modifiers[index] * multiplier));
+		}
+	}
+}
+
+void BlockCompression::EncodeBC1(const unsigned char* rgba, unsigned char* block, bool allowAlpha)
+{
+	float pixels[16][4];
+	int opaqueCount = 0;
+	bool transparent = false;
+	for (int i = 0; i < 16; i++)
+	{
+		// see-through pixels get the transparent index, so they don't count towards the colours
+		if (allowAlpha && rgba[i * 4 + 3] < 128)
+		{
+			transparent = true;
+			continue;
+		}
+		for (int c = 0; c < 3; c++)
+			pixels[opaqueCount][c] = rgba[i * 4 + c];
+		opaqueCount++;
+	}
+
+	memset(block, 0, 8);
+	if (opaqueCount == 0)
+	{
+		// c0 <= c1 with every index 3 is fully transparent
+		memset(block + 4, 0xFF, 4);
+		return;
+	}
+
+	float mean[4];
+	float axis[4];
+	PrincipalAxis(pixels, opaqueCount, 3, mean, axis);
+	float low = 0;
+	float high = 0;
+	for (int i = 0; i < opaqueCount; i++)
+	{
+		float t = (pixels[i][0] - mean[0]) * axis[0] + (pixels[i][1] - mean[1]) * axis[1] + (pixels[i][2] - mean[2]) * axis[2];
+		low = std::min(low, t);
+		high = std::max(high, t);
+	}
+
+	uint16_t c0 = To565(mean[0] + axis[0] * high, mean[1] + axis[1] * high, mean[2] + axis[2] * high);
+	uint16_t c1 = To565(mean[0] + axis[0] * low, mean[1] + axis[1] * low, mean[2] + axis[2] * low);
+
+	// four colour blocks need c0 > c1, three colour ones (with the transparent index) need c0 <= c1
+	if (transparent ? c0 > c1 : c0 < c1)
+		std::swap(c0, c1);
+
+	int palette[4][4];
+	BC1Palette(c0, c1, transparent, palette);
+
+	uint32_t indices = 0;
+	for (int i = 0; i < 16; i++)
+	{
+		int index = 0;
+		if (transparent && rgba[i * 4 + 3] < 128)
+			index = 3;
+		else if (c0 != c1)
+		{
+			int best = INT32_MAX;
+			for (int p = 0; p < (transparent ? 3 : 4); p++)
+			{
+				int error = 0;
+				for (int c = 0; c < 3; c++)
+				{
+					int d = rgba[i * 4 + c] - palette[p][c];
+					error += d * d;
+				}
+				if (error < best)
+				{
+					best = error;
+					index = p;
+				}
+			}
+		}
+		indices |= static_cast<uint32_t>(index) << (i * 2);
+	}
+
+	block[0] = static_cast<unsigned char>(c0);
+	block[1] = static_cast<unsigned char>(c0 >> 8);
+	block[2] = static_cast<unsigned char>(c1);
+	block[3] = static_cast<unsigned char>(c1 >> 8);
+	for (int i = 0; i < 4; i++)
+		block[4 + i] = static_cast<unsigned char>(indices >> (i * 8));
+}
+
+void BlockCompression::EncodeBC3Alpha(const unsigned char* rgba, unsigned char* block)
+{
+	int low = 255;
+	int high = 0;
+	for (int i = 0; i < 16; i++)
+	{
+		low = std::min(low, static_cast<int>(rgba[i * 4 + 3]));
+		high = std::max(high, static_cast<int>(rgba[i * 4 + 3]));
+	}
+
+	memset(block, 0, 8);
+	block[0] = static_cast<unsigned char>(high);
+	block[1] = static_cast<unsigned char>(low);
+	if (high == low)
+		return;
+
+	// a0 > a1 gives 8 evenly spaced alphas
+	int palette[8] = { high, low };
+	for (int i = 1; i < 7; i++)
+		palette[i + 1] = ((7 - i) * high + i * low) / 7;
+
+	uint64_t indices = 0;
+	for (int i = 0; i < 16; i++)
+	{
+		int a = rgba[i * 4 + 3];
+		int index = 0;
+		for (int p = 1; p < 8; p++)
+			if (std::abs(palette[p] - a) < std::abs(palette[index] - a))
+				index = p;
+		indices |= static_cast<uint64_t>(index) << (i * 3);
+	}
+	for (int i = 0; i < 6; i++)
+		block[2 + i] = static_cast<unsigned char>(indices >> (i * 8));
+}
+
+void BlockCompression::EncodeBC7(const unsigned char* rgba, unsigned char* block)
+{
+	// mode 6: one subset, 7 bit RGBA endpoints with a p-bit each, 4 bit indices
+	float pixels[16][4];
+	for (int i = 0; i < 16; i++)
+		for (int c = 0; c < 4; c++)
+			pixels[i][c] = rgba[i * 4 + c];
+
+	float mean[4];
+	float axis[4];
+	PrincipalAxis(pixels, 16, 4, mean, axis);
+	float low = 0;
+	float high = 0;
+	for (int i = 0; i < 16; i++)
+	{
+		float t = 0;
+		for (int c = 0; c < 4; c++)
+			t += (pixels[i][c] - mean[c]) * axis[c];
+		low = std::min(low, t);
+		high = std::max(high, t);
+	}
+
+	float ends[2][4];
+	for (int c = 0; c < 4; c++)
+	{
+		ends[0][c] = mean[c] + axis[c] * low;
+		ends[1][c] = mean[c] + axis[c] * high;
+	}
+
+	// try every p-bit pair and keep whichever is closest
+	int bestError = INT32_MAX;
+	int bestQuantized[2][4] = {};
+	int bestPBits[2] = {};
+	int bestIndices[16] = {};
+	for (int pBits = 0; pBits < 4; pBits++)
+	{
+		int p[2] = { pBits & 1, pBits >> 1 };
+		int quantized[2][4];
+		int endpoints[2][4];
+		for (int e = 0; e < 2; e++)
+		{
+			for (int c = 0; c < 4; c++)
+			{
+				quantized[e][c] = std::clamp(static_cast<int>(std::lround((ends[e][c] - p[e]) / 2.0f)), 0, 127);
+				endpoints[e][c] = (quantized[e][c] << 1) | p[e];
+			}
+		}
+
+		int error = 0;
+		int indices[16];
+		for (int i = 0; i < 16; i++)
+		{
+			int best = INT32_MAX;
+			for (int w = 0; w < 16; w++)
+			{
+				int e = 0;
+				for (int c = 0; c < 4; c++)
+				{
+					int value = ((64 - bc7Weights4[w]) * endpoints[0][c] + bc7Weights4[w] * endpoints[1][c] + 32) >> 6;
+					int d = value - rgba[i * 4 + c];
+					e += d * d;
+				}
+				if (e < best)
+				{
+					best = e;
+					indices[i] = w;
+				}
+			}
+			error += best;
+		}
+
+		if (error < bestError)
+		{
+			bestError = error;
+			memcpy(bestQuantized, quantized, sizeof(quantized));
+			memcpy(bestIndices, indices, sizeof(indices));
+			bestPBits[0] = p[0];
+			bestPBits[1] = p[1];
+		}
+	}
+
+	// pixel 0's index only has 3 bits, so its top bit has to be 0
+	if (bestIndices[0] & 8)
+	{
+		for (int c = 0; c < 4; c++)
+			std::swap(bestQuantized[0][c], bestQuantized[1][c]);
+		std::swap(bestPBits[0], bestPBits[1]);
+		for (int i = 0; i < 16; i++)
+			bestIndices[i] = 15 - bestIndices[i];
+	}
+
+	memset(block, 0, 16);
+	BitWriter bits{ block };
+	bits.Write(1 << 6, 7);
+	for (int c = 0; c < 4; c++)
+		for (int e = 0; e < 2; e++)
+			bits.Write(bestQuantized[e][c], 7);
+	bits.Write(bestPBits[0], 1);
+	bits.Write(bestPBits[1], 1);
+	for (int i = 0; i < 16; i++)
+		bits.Write(bestIndices[i], i == 0 ? 3 : 4);
+}
+
+#endif // !BLOCKCOMPRESSION_CPP
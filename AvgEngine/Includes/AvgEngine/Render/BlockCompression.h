@@ -0,0 +1,147 @@
+/*
+	Copyright 2021-2023 AvgEngine - Kade
+
+	Use of this source code without explict permission from owner is strictly prohibited.
+*/
+
+#ifndef BLOCKCOMPRESSION_H
+#define BLOCKCOMPRESSION_H
+
+#pragma once
+
+#include <vector>
+#include <string>
+#include <cstdint>
+
+namespace AvgEngine::Render
+{
+	/**
+	 * \brief GPU block compressed formats (every one of them stores 4x4 pixel blocks)
+	 */
+	enum class BlockFormat
+	{
+		None = 0,
+		/**
+		 * \brief 8 bytes a block, RGB with 1 bit alpha (DXT1)
+		 */
+		BC1,
+		/**
+		 * \brief 16 bytes a block, BC1 colour with a separate alpha block (DXT5)
+		 */
+		BC3,
+		/**
+		 * \brief 16 bytes a block, high quality RGBA
+		 */
+		BC7,
+		/**
+		 * \brief 8 bytes a block, RGB
+		 */
+		ETC2_RGB,
+		/**
+		 * \brief 16 bytes a block, ETC2 colour with an EAC alpha block
+		 */
+		ETC2_RGBA
+	};
+
+	/**
+	 * \brief One mip level of a compressed image
+	 */
+	struct CompressedLevel
+	{
+		int width = 0, height = 0;
+		std::vector<unsigned char> data;
+	};
+
+	/**
+	 * \brief A block compressed image (and its mip levels, biggest first)
+	 */
+	struct CompressedImage
+	{
+		BlockFormat format = BlockFormat::None;
+		int width = 0, height = 0;
+		std::vector<CompressedLevel> levels;
+	};
+
+	/**
+	 * \brief Reads, writes, encodes and decodes block compressed images. None of this touches OpenGL, so it's fine on any thread (and in tools).
+	 */
+	class BlockCompression
+	{
+	public:
+		static const char* FormatName(BlockFormat format);
+
+		/**
+		 * \brief How many bytes one 4x4 block takes up
+		 */
+		static size_t BlockBytes(BlockFormat format);
+
+		/**
+		 * \brief How many bytes a w x h level takes up (partial blocks on the edges count as whole ones)
+		 */
+		static size_t LevelBytes(BlockFormat format, int w, int h);
+
+		/**
+		 * \brief If a file is a compressed texture container (.dds or .ktx2), going by its extension
+		 */
+		static bool IsContainer(const std::string& filePath);
+
+		/**
+		 * \brief Reads a .dds (BC1, BC3, BC7) or .ktx2 (BC1, BC3, BC7, ETC2, no supercompression) file
+		 * \param filePath The file path
+		 * \param out The image
+		 * \param error Why it couldn't be read
+		 * \return If it was read
+		 */
+		static bool Read(const std::string& filePath, CompressedImage& out, std::string& error);
+
+		/**
+		 * \brief Writes a .dds file (BC1, BC3 or BC7)
+		 */
+		static bool WriteDDS(const std::string& filePath, const CompressedImage& image, std::string& error);
+
+		/**
+		 * \brief Decodes a level to RGBA (for when the GPU can't sample the format)
+		 * \param format The level's format
+		 * \param level The level to decode
+		 * \param out Where to write the pixels (level.width * level.height * 4)
+		 */
+		static void Decode(BlockFormat format, const CompressedLevel& level, unsigned char* out);
+
+		/**
+		 * \brief Encodes RGBA pixels. BC1, BC3 and BC7 (single subset, mode 6) can be encoded, ETC2 can only be decoded.
+		 * \param format The format to encode to
+		 * \param rgba The pixels (w * h * 4)
+		 * \param w The width
+		 * \param h The height
+		 * \param out The level
+		 * \return If the format can be encoded
+		 */
+		static bool Encode(BlockFormat format, const unsigned char* rgba, int w, int h, CompressedLevel& out);
+
+		/**
+		 * \brief Decodes one 4x4 block to 64 bytes of RGBA
+		 */
+		static void DecodeBlock(BlockFormat format, const unsigned char* block, unsigned char* out);
+
+		/**
+		 * \brief Encodes 64 bytes of RGBA to one 4x4 block
+		 */
+		static bool EncodeBlock(BlockFormat format, const unsigned char* rgba, unsigned char* block);
+
+	private:
+		static void DecodeBC1(const unsigned char* block, unsigned char* out, bool threeColour);
+		static void DecodeBC3Alpha(const unsigned char* block, unsigned char* out);
+		static void DecodeBC7(const unsigned char* block, unsigned char* out);
+		static void DecodeETC2(const unsigned char* block, unsigned char* out);
+		static void DecodeEAC(const unsigned char* block, unsigned char* out);
+
+		static void EncodeBC1(const unsigned char* rgba, unsigned char* block, bool allowAlpha);
+		static void EncodeBC3Alpha(const unsigned char* rgba, unsigned char* block);
+		static void EncodeBC7(const unsigned char* rgba, unsigned char* block);
+
+		static bool ReadDDS(const std::vector<unsigned char>& file, CompressedImage& out, std::string& error);
+		static bool ReadKTX2(const std::vector<unsigned char>& file, CompressedImage& out, std::string& error);
+	};
+}
+
+#endif // !BLOCKCOMPRESSION_H
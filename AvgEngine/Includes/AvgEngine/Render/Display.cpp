@@ -5,8 +5,11 @@
 */
 
 #include <AvgEngine/Render/Display.h>
+#include <AvgEngine/Render/OpenGL/Extensions.h>
+#include <AvgEngine/Render/OpenGL/StateCache.h>
 
 #include <Glad/glad.h>
+#include <algorithm>
 
 using namespace AvgEngine;
 
@@ -19,53 +22,240 @@ int AvgEngine::Render::Display::width = 0;
 std::vector<AvgEngine::Render::Vertex> AvgEngine::Render::Display::batch_buffer{};
 GLuint AvgEngine::Render::Display::batch_vao{};
 GLuint AvgEngine::Render::Display::batch_vbo{};
+size_t AvgEngine::Render::Display::batch_vbo_size = 65536;
+size_t AvgEngine::Render::Display::batch_vbo_offset = 0;
+GLuint AvgEngine::Render::Display::batch_ebo{};
+size_t AvgEngine::Render::Display::batch_ebo_quads = 0;
+GLuint AvgEngine::Render::Display::instance_vao{};
+GLuint AvgEngine::Render::Display::instance_vbo{};
+size_t AvgEngine::Render::Display::instance_vbo_size = 16384;
+size_t AvgEngine::Render::Display::instance_vbo_offset = 0;
 
 OpenGL::Shader* Render::Display::defaultShader = NULL;
+OpenGL::Shader* Render::Display::instancedShader = NULL;
+std::vector<OpenGL::Shader*> Render::Display::projectedShaders{};
+glm::mat4 Render::Display::projection{};
+GLuint Render::Display::frame_ubo = 0;
+OpenGL::FrameBlock Render::Display::frame{};
 
 void AvgEngine::Render::Display::Init()
 {
+	// before any shaders are compiled, so they can come from the program cache
+	OpenGL::Extensions::Load();
+
 	glEnable(GL_BLEND);
 	glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
 	glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
 
 	glGenVertexArrays(1, &batch_vao);
-	glBindVertexArray(batch_vao);
+	OpenGL::StateCache::BindVertexArray(batch_vao);
 
 	glEnableVertexAttribArray(0);
 	glEnableVertexAttribArray(1);
 	glEnableVertexAttribArray(2);
 
 	glGenBuffers(1, &batch_vbo);
+	OpenGL::StateCache::BindBuffer(GL_ARRAY_BUFFER, batch_vbo);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(Vertex) * batch_vbo_size, NULL, GL_STREAM_DRAW);
+	batch_vbo_offset = 0;
+
+	// the buffer's name never changes (it's only ever orphaned), so these stay valid
+	glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), reinterpret_cast<GLvoid*>(offsetof(Vertex, x)));
+	glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), reinterpret_cast<GLvoid*>(offsetof(Vertex, u)));
+	glVertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(Vertex), reinterpret_cast<GLvoid*>(offsetof(Vertex, colour)));
+
+	// the index buffer is part of the VAO's state, so it only needs binding here
+	glGenBuffers(1, &batch_ebo);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, batch_ebo);
+	ReserveQuadIndices(batch_vbo_size / 4);
+
+	// uniform buffers are core in 3.1, so the frame block is always there unless it's turned off
+	if (OpenGL::Shader::useFrameBlock)
+	{
+		glGenBuffers(1, &frame_ubo);
+		OpenGL::StateCache::BindBuffer(GL_UNIFORM_BUFFER, frame_ubo);
+		glBufferData(GL_UNIFORM_BUFFER, sizeof(OpenGL::FrameBlock), &frame, GL_DYNAMIC_DRAW);
+		OpenGL::StateCache::BindBufferBase(OpenGL::Shader::frameBlockBinding, frame_ubo);
+	}
 
 	defaultShader = new OpenGL::Shader();
 	defaultShader->GL_CompileShader(NULL, NULL);
+
+	// Instance divisors are core in 3.3, before that they need ARB_instanced_arrays
+	if (OpenGL::Extensions::vertexAttribDivisor != NULL)
+	{
+		glGenVertexArrays(1, &instance_vao);
+		OpenGL::StateCache::BindVertexArray(instance_vao);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, batch_ebo);
+
+		glGenBuffers(1, &instance_vbo);
+		OpenGL::StateCache::BindBuffer(GL_ARRAY_BUFFER, instance_vbo);
+		glBufferData(GL_ARRAY_BUFFER, sizeof(SpriteInstance) * instance_vbo_size, NULL, GL_STREAM_DRAW);
+		instance_vbo_offset = 0;
+
+		for (int i = 3; i <= 6; i++)
+		{
+			glEnableVertexAttribArray(i);
+			OpenGL::Extensions::vertexAttribDivisor(i, 1);
+		}
+
+		instancedShader = new OpenGL::Shader();
+		instancedShader->GL_CompileShader(OpenGL::instanced_shader_vert, NULL);
+	}
+	else
+		Logging::writeLog("[Display] [Warning] Instanced arrays aren't supported, sprites will be drawn on the CPU path.");
+
+	OpenGL::StateCache::BindVertexArray(batch_vao);
 }
 
-void AvgEngine::Render::Display::DrawBuffer(AvgEngine::OpenGL::Texture* tex, OpenGL::Shader* shad)
+AvgEngine::Render::Vertex* AvgEngine::Render::Display::MapStream(size_t count, GLint* first)
 {
-	if (batch_buffer.size() == 0)
+	OpenGL::StateCache::BindBuffer(GL_ARRAY_BUFFER, batch_vbo);
+
+	if (count > batch_vbo_size)
+	{
+		// Too big for the ring, grow it (doubling so we don't end up doing this every frame)
+		while (batch_vbo_size < count)
+			batch_vbo_size *= 2;
+		batch_vbo_offset = batch_vbo_size;
+	}
+
+	if (batch_vbo_offset + count > batch_vbo_size)
+	{
+		// Orphan the old storage, the driver keeps it alive until the GPU is done with it
+		glBufferData(GL_ARRAY_BUFFER, sizeof(Vertex) * batch_vbo_size, NULL, GL_STREAM_DRAW);
+		batch_vbo_offset = 0;
+	}
+
+	// Nothing in the GPU's queue is using this range, so we don't need to sync
+	void* mapped = glMapBufferRange(GL_ARRAY_BUFFER, sizeof(Vertex) * batch_vbo_offset, sizeof(Vertex) * count,
+		GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+
+	if (mapped == NULL)
+	{
+		Logging::writeLog("[Display] [Error] Failed to map the streaming vertex buffer");
+		return NULL;
+	}
+
+	*first = static_cast<GLint>(batch_vbo_offset);
+	batch_vbo_offset += count;
+	return static_cast<Vertex*>(mapped);
+}
+
+void AvgEngine::Render::Display::UnmapStream()
+{
+	glUnmapBuffer(GL_ARRAY_BUFFER);
+}
+
+void AvgEngine::Render::Display::ReserveQuadIndices(size_t quads)
+{
+	if (quads <= batch_ebo_quads)
 		return;
 
-	glBindVertexArray(batch_vao);
-	glBindBuffer(GL_ARRAY_BUFFER, batch_vbo);
+	size_t newQuads = batch_ebo_quads == 0 ? quads : batch_ebo_quads;
+	while (newQuads < quads)
+		newQuads *= 2;
 
+	std::vector<GLuint> indices;
+	indices.reserve(newQuads * 6);
+	for (GLuint q = 0; q < newQuads; q++)
+	{
+		GLuint v = q * 4;
+		indices.push_back(v);
+		indices.push_back(v + 1);
+		indices.push_back(v + 2);
+		indices.push_back(v + 2);
+		indices.push_back(v + 1);
+		indices.push_back(v + 3);
+	}
 
-	shad->GL_Use();
+	OpenGL::StateCache::BindVertexArray(batch_vao);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, batch_ebo);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(GLuint) * indices.size(), indices.data(), GL_STATIC_DRAW);
+	batch_ebo_quads = newQuads;
+}
 
-	tex->Bind();
+void AvgEngine::Render::Display::DrawQuads(GLint first, GLsizei count)
+{
+	size_t quads = count / 4;
+	ReserveQuadIndices(quads);
+	// base vertex lets every range use the indices from the start of the buffer
+	glDrawElementsBaseVertex(GL_TRIANGLES, static_cast<GLsizei>(quads * 6), GL_UNSIGNED_INT, NULL, first);
+}
 
+void AvgEngine::Render::Display::DrawInstances(const SpriteInstance* instances, size_t count)
+{
+	if (count == 0)
+		return;
 
-	//Set attribute pointers
-	glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), reinterpret_cast<GLvoid*>(offsetof(Vertex, x)));
-	glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), reinterpret_cast<GLvoid*>(offsetof(Vertex, u)));
-	glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), reinterpret_cast<GLvoid*>(offsetof(Vertex, r)));
+	OpenGL::StateCache::BindVertexArray(instance_vao);
+	OpenGL::StateCache::BindBuffer(GL_ARRAY_BUFFER, instance_vbo);
+
+	if (count > instance_vbo_size)
+	{
+		while (instance_vbo_size < count)
+			instance_vbo_size *= 2;
+		instance_vbo_offset = instance_vbo_size;
+	}
+
+	if (instance_vbo_offset + count > instance_vbo_size)
+	{
+		// Orphan, same as the vertex stream
+		glBufferData(GL_ARRAY_BUFFER, sizeof(SpriteInstance) * instance_vbo_size, NULL, GL_STREAM_DRAW);
+		instance_vbo_offset = 0;
+	}
+
+	size_t offset = sizeof(SpriteInstance) * instance_vbo_offset;
+	void* mapped = glMapBufferRange(GL_ARRAY_BUFFER, offset, sizeof(SpriteInstance) * count,
+		GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+	if (mapped == NULL)
+	{
+		Logging::writeLog("[Display] [Error] Failed to map the streaming instance buffer");
+		return;
+	}
+	std::copy(instances, instances + count, static_cast<SpriteInstance*>(mapped));
+	glUnmapBuffer(GL_ARRAY_BUFFER);
+	instance_vbo_offset += count;
+
+	// No base instance in 3.2, so the pointers carry the offset instead
+	glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, sizeof(SpriteInstance), reinterpret_cast<GLvoid*>(offset + offsetof(SpriteInstance, dstX)));
+	glVertexAttribPointer(4, 4, GL_FLOAT, GL_FALSE, sizeof(SpriteInstance), reinterpret_cast<GLvoid*>(offset + offsetof(SpriteInstance, srcX)));
+	glVertexAttribPointer(5, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(SpriteInstance), reinterpret_cast<GLvoid*>(offset + offsetof(SpriteInstance, colour)));
+	glVertexAttribPointer(6, 3, GL_FLOAT, GL_FALSE, sizeof(SpriteInstance), reinterpret_cast<GLvoid*>(offset + offsetof(SpriteInstance, scale)));
+
+	glDrawElementsInstanced(GL_TRIANGLES, 6, GL_UNSIGNED_INT, NULL, static_cast<GLsizei>(count));
+}
+
+void AvgEngine::Render::Display::BindBatch()
+{
+	OpenGL::StateCache::BindVertexArray(batch_vao);
+}
+
+void AvgEngine::Render::Display::DrawBuffer(AvgEngine::OpenGL::Texture* tex, OpenGL::Shader* shad, bool quads)
+{
+	if (batch_buffer.size() == 0)
+		return;
+
+	BindBatch();
+
+	shad->GL_Use();
+
+	tex->Bind();
 
-	glBufferData(GL_ARRAY_BUFFER, sizeof(Vertex) * batch_buffer.size(), batch_buffer.data(), GL_STATIC_DRAW);
-	glDrawArrays(GL_TRIANGLES, 0, batch_buffer.size());
+	GLint first = 0;
+	Vertex* mapped = MapStream(batch_buffer.size(), &first);
+	if (mapped != NULL)
+	{
+		std::copy(batch_buffer.begin(), batch_buffer.end(), mapped);
+		UnmapStream();
+		if (quads)
+			DrawQuads(first, static_cast<GLsizei>(batch_buffer.size()));
+		else
+			glDrawArrays(GL_TRIANGLES, first, static_cast<GLsizei>(batch_buffer.size()));
+	}
 
 
 	batch_buffer.clear(); // clear it out
-	glUseProgram(NULL);
 }
 
 #endif // !DISPLAY_CPP
\ No newline at end of file
@@ -11,18 +11,37 @@
 
 #include <AvgEngine/Render/OpenGL/Shader.h>
 #include <AvgEngine/Render/OpenGL/Texture.h>
+#include <AvgEngine/Render/OpenGL/StateCache.h>
 
 #include <GLFW/glfw3.h>
+#include <algorithm>
+#include <cstdint>
+#include <span>
 
 #include <AvgEngine/Utils/Logging.h>
 
 namespace AvgEngine::Render
 {
+	/**
+	 * \brief A packed vertex (20 bytes). Colour is stored as RGBA8 and gets normalized by OpenGL.
+	 */
 	struct Vertex
 	{
 		float x = 0, y = 0;
 		float u = 0, v = 0;
-		float r = 1, g = 1, b = 1, a = 1;
+		uint32_t colour = 0xFFFFFFFF;
+
+		/**
+		 * \brief Packs a 0-1 colour into RGBA8 (r is the lowest byte, so it's first in memory)
+		 */
+		static uint32_t PackColour(float _r, float _g, float _b, float _a)
+		{
+			auto channel = [](float c) {
+				c = c < 0 ? 0 : (c > 1 ? 1 : c);
+				return static_cast<uint32_t>(c * 255.0f + 0.5f);
+			};
+			return channel(_r) | (channel(_g) << 8) | (channel(_b) << 16) | (channel(_a) << 24);
+		}
 
 		Vertex()
 		{
@@ -35,10 +54,16 @@ namespace AvgEngine::Render
 			y = _y;
 			u = _u;
 			v = _v;
-			r = _r;
-			g = _g;
-			b = _b;
-			a = _a;
+			colour = PackColour(_r, _g, _b, _a);
+		}
+
+		Vertex(float _x, float _y, float _u, float _v, uint32_t _colour)
+		{
+			x = _x;
+			y = _y;
+			u = _u;
+			v = _v;
+			colour = _colour;
 		}
 
 		Vertex(float _x, float _y, float _u, float _v)
@@ -47,13 +72,11 @@ namespace AvgEngine::Render
 			y = _y;
 			u = _u;
 			v = _v;
-			r = 1;
-			g = 1;
-			b = 1;
-			a = 1;
 		}
 	};
 
+	static_assert(sizeof(Vertex) == 20, "Vertex should stay packed, the attribute layout in Display depends on it");
+
 	struct Rect
 	{
 		float x = 0, y = 0;
@@ -108,13 +131,13 @@ namespace AvgEngine::Render
 			a = _r.a;
 		}
 
-		bool operator==(const Rect& other) {
+		bool operator==(const Rect& other) const {
 			// == with tolerance
 			return (std::abs(x - other.x) < 0.001f) && (std::abs(y - other.y) < 0.001f) && (std::abs(w - other.w) < 0.001f) && (std::abs(h - other.h) < 0.001f) && (std::abs(r - other.r) < 0.001f) && (std::abs(g - other.g) < 0.001f) && (std::abs(b - other.b) < 0.001f) && (std::abs(a - other.a) < 0.001f);
 
 		}
 
-		bool operator!=(const Rect& other) {
+		bool operator!=(const Rect& other) const {
 			// != with tolerance
 			return (std::abs(x - other.x) > 0.001f) || (std::abs(y - other.y) > 0.001f) || (std::abs(w - other.w) > 0.001f) || (std::abs(h - other.h) > 0.001f) || (std::abs(r - other.r) > 0.001f) || (std::abs(g - other.g) > 0.001f) || (std::abs(b - other.b) > 0.001f) || (std::abs(a - other.a) > 0.001f);
 
@@ -125,18 +148,33 @@ namespace AvgEngine::Render
 		}
 	};
 
+	/**
+	 * \brief One sprite for the instanced path (48 bytes). The quad is built from this in instanced_shader_vert.
+	 */
+	struct SpriteInstance
+	{
+		float dstX = 0, dstY = 0, dstW = 0, dstH = 0;
+		float srcX = 0, srcY = 0, srcW = 1, srcH = 1;
+		uint32_t colour = 0xFFFFFFFF;
+		float scale = 1;
+		float angle = 0;
+		float center = 0;
+	};
+
+	static_assert(sizeof(SpriteInstance) == 48, "SpriteInstance should stay packed, the attribute layout in Display depends on it");
+
 	class DisplayHelper
 	{
 	public:
 		/**
-		 * \brief A helper function to convert two Rect structs to a Vertex Array
+		 * \brief A helper function to write the four corners of a quad (tl, bl, tr, br) for two Rect structs.
+		 * These are meant to be drawn with the shared quad index buffer.
+		 * \param out Where to write the vertices (usually from Camera::reserveVertices)
 		 * \param dst The destination struct
 		 * \param src The source struct
-		 * \return An array of Vertex's
 		 */
-		static std::vector<Vertex> RectToVertex(Rect dst, Rect src, bool center = false)
+		static void RectToQuad(std::span<Vertex, 4> out, Rect dst, Rect src, bool center = false)
 		{
-			std::vector<Vertex> verts;
 
 			Rect rD = dst;
 			if (center)
@@ -150,46 +188,35 @@ namespace AvgEngine::Render
 			rD.w *= rD.scale;
 			rD.h *= rD.scale;
 
+			uint32_t colour = Vertex::PackColour(rD.r / 255, rD.g / 255, rD.b / 255, rD.a);
 
 			Vertex tl;
 			tl.x = rD.x;
 			tl.y = rD.y;
 			tl.u = src.x;
 			tl.v = src.y;
-			tl.r = rD.r / 255;
-			tl.g = rD.g / 255;
-			tl.b = rD.b / 255;
-			tl.a = rD.a;
+			tl.colour = colour;
 
 			Vertex bl;
 			bl.x = rD.x;
 			bl.y = rD.y + rD.h;
 			bl.u = src.x;
 			bl.v = src.y + src.h;
-			bl.r = rD.r / 255;
-			bl.g = rD.g / 255;
-			bl.b = rD.b / 255;
-			bl.a = rD.a;
+			bl.colour = colour;
 
 			Vertex tr;
 			tr.x = rD.x + rD.w;
 			tr.y = rD.y;
 			tr.u = src.x + src.w;
 			tr.v = src.y;
-			tr.r = rD.r / 255;
-			tr.g = rD.g / 255;
-			tr.b = rD.b / 255;
-			tr.a = rD.a;
+			tr.colour = colour;
 
 			Vertex br;
 			br.x = rD.x + rD.w;
 			br.y = rD.y + rD.h;
 			br.u = src.x + src.w;
 			br.v = src.y + src.h;
-			br.r = rD.r / 255;
-			br.g = rD.g / 255;
-			br.b = rD.b / 255;
-			br.a = rD.a;
+			br.colour = colour;
 
 			if (rD.angle != 0)
 			{
@@ -210,15 +237,117 @@ namespace AvgEngine::Render
 				}
 			}
 
-			verts.push_back(tl);
-			verts.push_back(bl);
-			verts.push_back(tr);
-			verts.push_back(tr);
-			verts.push_back(bl);
-			verts.push_back(br);
+			out[0] = tl;
+			out[1] = bl;
+			out[2] = tr;
+			out[3] = br;
+		}
+
+		/**
+		 * \brief A helper function to convert two Rect structs to the four corners of a quad (tl, bl, tr, br).
+		 * \param dst The destination struct
+		 * \param src The source struct
+		 * \return An array of 4 Vertex's
+		 */
+		static std::vector<Vertex> RectToQuad(Rect dst, Rect src, bool center = false)
+		{
+			std::vector<Vertex> verts(4);
+			RectToQuad(std::span<Vertex, 4>(verts.data(), 4), dst, src, center);
 			return verts;
 		}
 
+		/**
+		 * \brief The box RectToQuad's vertices fit in (after scaling, centering, and rotating)
+		 * \param dst The destination struct
+		 * \return The box (with no scale or angle)
+		 */
+		static Rect QuadBounds(Rect dst, bool center = false)
+		{
+			Rect b = dst;
+			if (center)
+			{
+				b.x += (b.w * (1 - b.scale)) / 2;
+				b.y += (b.h * (1 - b.scale)) / 2;
+			}
+			b.w *= b.scale;
+			b.h *= b.scale;
+
+			if (b.angle != 0)
+			{
+				float s = std::abs(static_cast<float>(sin(b.angle * (3.14159265 / 180))));
+				float c = std::abs(static_cast<float>(cos(b.angle * (3.14159265 / 180))));
+				float cx = b.x + b.w * 0.5f;
+				float cy = b.y + b.h * 0.5f;
+				float w = std::abs(b.w) * c + std::abs(b.h) * s;
+				float h = std::abs(b.w) * s + std::abs(b.h) * c;
+				b.x = cx - w / 2;
+				b.y = cy - h / 2;
+				b.w = w;
+				b.h = h;
+			}
+
+			b.scale = 1;
+			b.angle = 0;
+			return b;
+		}
+
+		/**
+		 * \brief A helper function to write two Rect structs as two triangles (for non-indexed drawing)
+		 * \param out Where to write the vertices
+		 * \param dst The destination struct
+		 * \param src The source struct
+		 */
+		static void RectToVertex(std::span<Vertex, 6> out, Rect dst, Rect src, bool center = false)
+		{
+			Vertex quad[4];
+			RectToQuad(quad, dst, src, center);
+
+			// tl, bl, tr, tr, bl, br
+			out[0] = quad[0];
+			out[1] = quad[1];
+			out[2] = quad[2];
+			out[3] = quad[2];
+			out[4] = quad[1];
+			out[5] = quad[3];
+		}
+
+		/**
+		 * \brief A helper function to convert two Rect structs to a Vertex Array (two triangles, for non-indexed drawing)
+		 * \param dst The destination struct
+		 * \param src The source struct
+		 * \return An array of Vertex's
+		 */
+		static std::vector<Vertex> RectToVertex(Rect dst, Rect src, bool center = false)
+		{
+			std::vector<Vertex> verts(6);
+			RectToVertex(std::span<Vertex, 6>(verts.data(), 6), dst, src, center);
+			return verts;
+		}
+
+		/**
+		 * \brief A helper function to convert two Rect structs to a sprite instance
+		 * \param dst The destination struct
+		 * \param src The source struct
+		 * \return The instance
+		 */
+		static SpriteInstance RectToInstance(Rect dst, Rect src, bool center = false)
+		{
+			SpriteInstance i;
+			i.dstX = dst.x;
+			i.dstY = dst.y;
+			i.dstW = dst.w;
+			i.dstH = dst.h;
+			i.srcX = src.x;
+			i.srcY = src.y;
+			i.srcW = src.w;
+			i.srcH = src.h;
+			i.colour = Vertex::PackColour(dst.r / 255, dst.g / 255, dst.b / 255, dst.a);
+			i.scale = dst.scale;
+			i.angle = dst.angle;
+			i.center = center ? 1.0f : 0.0f;
+			return i;
+		}
+
 		static int* getMonitorResolution()
 		{
 			static int* stored = nullptr;
@@ -237,6 +366,27 @@ namespace AvgEngine::Render
 	public:
 
 		static OpenGL::Shader* defaultShader;
+		/**
+		 * \brief The default shader for instanced sprites (NULL if instancing isn't supported)
+		 */
+		static OpenGL::Shader* instancedShader;
+		/**
+		 * \brief Other engine shaders that get the projection matrix in SetProject (like the SDF text shaders)
+		 */
+		static std::vector<OpenGL::Shader*> projectedShaders;
+		/**
+		 * \brief The last projection matrix given to SetProject
+		 */
+		static glm::mat4 projection;
+
+		/**
+		 * \brief The uniform buffer behind every shader's frame block (u_projection and iTime), 0 if shaders don't use it
+		 */
+		static GLuint frame_ubo;
+		/**
+		 * \brief What's in frame_ubo
+		 */
+		static OpenGL::FrameBlock frame;
 
 		static int width, height;
 
@@ -244,6 +394,35 @@ namespace AvgEngine::Render
 		static GLuint batch_vao;
 		static GLuint batch_vbo;
 
+		/**
+		 * \brief The size (in vertices) of the streaming vertex buffer
+		 */
+		static size_t batch_vbo_size;
+		/**
+		 * \brief Where (in vertices) the next write into the streaming vertex buffer goes
+		 */
+		static size_t batch_vbo_offset;
+
+		/**
+		 * \brief The shared index buffer for drawing quads (0,1,2, 2,1,3 for every 4 vertices)
+		 */
+		static GLuint batch_ebo;
+		/**
+		 * \brief How many quads batch_ebo has indices for
+		 */
+		static size_t batch_ebo_quads;
+
+		static GLuint instance_vao;
+		static GLuint instance_vbo;
+		/**
+		 * \brief The size (in instances) of the streaming instance buffer
+		 */
+		static size_t instance_vbo_size;
+		/**
+		 * \brief Where (in instances) the next write into the streaming instance buffer goes
+		 */
+		static size_t instance_vbo_offset;
+
 
 		/**
 		 * \brief A helper function to set the window's fullscreen property
@@ -315,21 +494,20 @@ namespace AvgEngine::Render
 		{
 			if (clip)
 			{
-				glEnable(GL_SCISSOR_TEST);
-				glScissor(clip->x, height - clip->h - clip->y, clip->w, clip->h);
+				OpenGL::StateCache::ScissorTest(true);
+				OpenGL::StateCache::Scissor(clip->x, height - clip->h - clip->y, clip->w, clip->h);
 			}
 			else
-				glDisable(GL_SCISSOR_TEST);
+				OpenGL::StateCache::ScissorTest(false);
 		}
 
 		/**
 		 * \brief Adds an array of vertices to the draw buffer.
 		 * \param verts The vertices to add
 		 */
-		static void AddVertex(std::vector<Vertex> verts)
+		static void AddVertex(const std::vector<Vertex>& verts)
 		{
-			for (Vertex v : verts)
-				batch_buffer.push_back(v);
+			batch_buffer.insert(batch_buffer.end(), verts.begin(), verts.end());
 		}
 
 		/**
@@ -339,7 +517,8 @@ namespace AvgEngine::Render
 		 */
 		static void AddVertex(Rect dst, Rect src)
 		{
-			AddVertex(DisplayHelper::RectToVertex(dst, src));
+			batch_buffer.resize(batch_buffer.size() + 6);
+			DisplayHelper::RectToVertex(std::span<Vertex, 6>(batch_buffer.data() + batch_buffer.size() - 6, 6), dst, src);
 		}
 
 		/**
@@ -350,12 +529,109 @@ namespace AvgEngine::Render
 			batch_buffer.clear();
 		}
 
+		/**
+		 * \brief Maps a range of the streaming vertex buffer so vertices can be written straight into it.
+		 * If the range doesn't fit in what's left of the buffer, the buffer is orphaned and writing starts over at the beginning.
+		 * \param count The amount of vertices to map
+		 * \param first A reference to a variable to output the index of the first mapped vertex (for glDrawArrays)
+		 * \return A pointer to the mapped vertices, or NULL if the map failed
+		 */
+		static Vertex* MapStream(size_t count, GLint* first);
+
+		/**
+		 * \brief Unmaps the range returned from MapStream
+		 */
+		static void UnmapStream();
+
+		/**
+		 * \brief Makes sure the quad index buffer has enough indices for a given amount of quads
+		 * \param quads The amount of quads
+		 */
+		static void ReserveQuadIndices(size_t quads);
+
+		/**
+		 * \brief Draws a range of the streaming buffer that is made up of quads (4 vertices each)
+		 * \param first The first vertex of the range
+		 * \param count The amount of vertices in the range
+		 */
+		static void DrawQuads(GLint first, GLsizei count);
+
+		/**
+		 * \brief Draws sprite instances with the instance VAO. The shader (instancedShader) and texture should already be bound.
+		 * \param instances The instances to draw
+		 * \param count The amount of instances
+		 */
+		static void DrawInstances(const SpriteInstance* instances, size_t count);
+
+		/**
+		 * \brief Writes the frame block to its buffer (every shader that reads it sees the change)
+		 */
+		static void UploadFrame()
+		{
+			if (frame_ubo == 0)
+				return;
+			OpenGL::StateCache::BindBuffer(GL_UNIFORM_BUFFER, frame_ubo);
+			glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(OpenGL::FrameBlock), &frame);
+		}
+
+		/**
+		 * \brief Sets iTime for shaders that read the frame block (every shader that doesn't declare iTime itself)
+		 * \param time The time in seconds
+		 */
+		static void SetTime(float time)
+		{
+			frame.time = time;
+			UploadFrame();
+		}
+
+		/**
+		 * \brief Sets the projection matrix in the frame block, and on shaders that have their own u_projection
+		 * \param proj The projection matrix
+		 */
+		static void SetProject(glm::mat4 proj)
+		{
+			projection = proj;
+			frame.projection = proj;
+			UploadFrame();
+			// these all return straight away if they read the frame block
+			defaultShader->setProject(proj);
+			if (instancedShader)
+				instancedShader->setProject(proj);
+			for (OpenGL::Shader* shader : projectedShaders)
+				shader->setProject(proj);
+		}
+
+		/**
+		 * \brief Makes a shader get the projection matrix whenever it changes (and gives it the current one)
+		 * \param shader The shader
+		 */
+		static void AddProjectedShader(OpenGL::Shader* shader)
+		{
+			projectedShaders.push_back(shader);
+			shader->setProject(projection);
+		}
+
+		/**
+		 * \brief Stops giving a shader the projection matrix (call this before deleting a shader added with AddProjectedShader)
+		 * \param shader The shader
+		 */
+		static void RemoveProjectedShader(OpenGL::Shader* shader)
+		{
+			projectedShaders.erase(std::remove(projectedShaders.begin(), projectedShaders.end(), shader), projectedShaders.end());
+		}
+
+		/**
+		 * \brief Binds the batch VAO (its attribute pointers are set once in Init, orphaning the buffer doesn't change them)
+		 */
+		static void BindBatch();
+
 		/**
 		 * \brief Draws the current buffer and clears it
 		 * \param tex The texture to associate the buffer with
 		 * \param shad The shader to associate the buffer with
+		 * \param quads If the buffer is made of quads (4 vertices each) instead of triangles
 		 */
-		static void DrawBuffer(AvgEngine::OpenGL::Texture* tex, OpenGL::Shader* shad);
+		static void DrawBuffer(AvgEngine::OpenGL::Texture* tex, OpenGL::Shader* shad, bool quads = false);
 
 	};
 }
@@ -0,0 +1,105 @@
+/*
+	Copyright 2021-2023 AvgEngine - Kade
+
+	Use of this source code without explict permission from owner is strictly prohibited.
+*/
+
+#include <AvgEngine/Render/DistanceField.h>
+
+#include <algorithm>
+#include <cmath>
+
+using namespace AvgEngine::Render;
+
+#ifndef DISTANCEFIELD_CPP
+#define DISTANCEFIELD_CPP
+
+void DistanceField::Sweep(std::vector<Offset>& grid, int w, int h)
+{
+	auto compare = [&](Offset& cell, int x, int y, int ox, int oy) {
+		int nx = x + ox;
+		int ny = y + oy;
+		if (nx < 0 || ny < 0 || nx >= w || ny >= h)
+			return;
+		Offset other = grid[ny * w + nx];
+		other.dx += ox;
+		other.dy += oy;
+		if (other.dist2() < cell.dist2())
+			cell = other;
+	};
+
+	for (int y = 0; y < h; y++)
+	{
+		for (int x = 0; x < w; x++)
+		{
+			Offset& cell = grid[y * w + x];
+			compare(cell, x, y, -1, 0);
+			compare(cell, x, y, 0, -1);
+			compare(cell, x, y, -1, -1);
+			compare(cell, x, y, 1, -1);
+		}
+		for (int x = w - 1; x >= 0; x--)
+			compare(grid[y * w + x], x, y, 1, 0);
+	}
+
+	for (int y = h - 1; y >= 0; y--)
+	{
+		for (int x = w - 1; x >= 0; x--)
+		{
+			Offset& cell = grid[y * w + x];
+			compare(cell, x, y, 1, 0);
+			compare(cell, x, y, 0, 1);
+			compare(cell, x, y, -1, 1);
+			compare(cell, x, y, 1, 1);
+		}
+		for (int x = 0; x < w; x++)
+			compare(grid[y * w + x], x, y, -1, 0);
+	}
+}
+
+void DistanceField::Generate(const unsigned char* rgba, int imageW, int x, int y, int w, int h, int spread, unsigned char* out, int outW)
+{
+	int fw = w + spread * 2;
+	int fh = h + spread * 2;
+
+	// one grid measures to the nearest inside pixel, the other to the nearest outside one
+	const Offset far = { 9999, 9999 };
+	std::vector<Offset> toInside(static_cast<size_t>(fw) * fh, far);
+	std::vector<Offset> toOutside(static_cast<size_t>(fw) * fh, Offset());
+
+	for (int gy = 0; gy < h; gy++)
+	{
+		for (int gx = 0; gx < w; gx++)
+		{
+			const unsigned char* p = rgba + (static_cast<size_t>(y + gy) * imageW + (x + gx)) * 4;
+			unsigned char coverage = std::min(p[3], std::max(p[0], std::max(p[1], p[2])));
+			if (coverage < 128)
+				continue;
+			size_t i = static_cast<size_t>(gy + spread) * fw + (gx + spread);
+			toInside[i] = Offset();
+			toOutside[i] = far;
+		}
+	}
+
+	Sweep(toInside, fw, fh);
+	Sweep(toOutside, fw, fh);
+
+	for (int fy = 0; fy < fh; fy++)
+	{
+		for (int fx = 0; fx < fw; fx++)
+		{
+			size_t i = static_cast<size_t>(fy) * fw + fx;
+			// positive outside, negative inside
+			float dist = std::sqrt(static_cast<float>(toInside[i].dist2())) - std::sqrt(static_cast<float>(toOutside[i].dist2()));
+			float value = std::clamp(0.5f - dist / (spread * 2.0f), 0.0f, 1.0f);
+
+			unsigned char* o = out + (static_cast<size_t>(fy) * outW + fx) * 4;
+			o[0] = 255;
+			o[1] = 255;
+			o[2] = 255;
+			o[3] = static_cast<unsigned char>(value * 255.0f + 0.5f);
+		}
+	}
+}
+
+#endif // !DISTANCEFIELD_CPP
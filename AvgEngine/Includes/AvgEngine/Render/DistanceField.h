@@ -0,0 +1,55 @@
+/*
+	Copyright 2021-2023 AvgEngine - Kade
+
+	Use of this source code without explict permission from owner is strictly prohibited.
+*/
+
+#ifndef DISTANCEFIELD_H
+#define DISTANCEFIELD_H
+
+#pragma once
+
+#include <vector>
+
+namespace AvgEngine::Render
+{
+	/**
+	 * \brief Makes signed distance fields out of bitmap glyphs (for SDF text)
+	 */
+	class DistanceField
+	{
+	public:
+		/**
+		 * \brief Turns part of an RGBA image into a distance field. Coverage is min(alpha, brightest channel), so both white-on-transparent and white-on-black glyphs work.
+		 * The field is written as white with the distance in alpha: 0.5 (128) is the edge, 1 is spread pixels inside, 0 is spread pixels outside.
+		 * \param rgba The source image
+		 * \param imageW The width of the source image
+		 * \param x The x of the region to convert
+		 * \param y The y of the region to convert
+		 * \param w The width of the region
+		 * \param h The height of the region
+		 * \param spread How many pixels the field reaches past the edge (the output gets this much padding on every side)
+		 * \param out Where to write the field (RGBA)
+		 * \param outW The width of out (the field is written at its top left)
+		 */
+		static void Generate(const unsigned char* rgba, int imageW, int x, int y, int w, int h, int spread, unsigned char* out, int outW);
+
+	private:
+		struct Offset
+		{
+			int dx = 0, dy = 0;
+
+			int dist2() const
+			{
+				return dx * dx + dy * dy;
+			}
+		};
+
+		/**
+		 * \brief 8SSEDT: fills every cell with the offset to the nearest cell that started at 0 (two passes, one each way)
+		 */
+		static void Sweep(std::vector<Offset>& grid, int w, int h);
+	};
+}
+
+#endif // !DISTANCEFIELD_H
@@ -0,0 +1,206 @@
+/*
+	Copyright 2021-2023 AvgEngine - Kade
+
+	Use of this source code without explict permission from owner is strictly prohibited.
+*/
+
+#include <AvgEngine/Render/Mipmaps.h>
+
+#include <algorithm>
+#include <cmath>
+
+using namespace AvgEngine::Render;
+
+#ifndef MIPMAPS_CPP
+#define MIPMAPS_CPP
+
+namespace
+{
+	/**
+	 * \brief Premultiplied RGBA, then straight RGB (used where everything is transparent, so those pixels keep a sensible colour to filter into)
+	 */
+	constexpr int channels = 7;
+
+	struct Tap
+	{
+		int first = 0;
+		std::vector<float> weights;
+	};
+
+	float Sinc(float x)
+	{
+		if (std::abs(x) < 0.0001f)
+			return 1;
+		const float pi = 3.14159265f;
+		return std::sin(pi * x) / (pi * x);
+	}
+
+	// zeroth order modified Bessel function, for the Kaiser window
+	float BesselI0(float x)
+	{
+		float sum = 1;
+		float term = 1;
+		for (int k = 1; k < 16; k++)
+		{
+			term *= (x / (2 * k)) * (x / (2 * k));
+			sum += term;
+		}
+		return sum;
+	}
+
+	/**
+	 * \brief Works out which source pixels (and how much of each) go into every destination pixel along one axis
+	 */
+	std::vector<Tap> Taps(MipMode mode, int source, int dest)
+	{
+		std::vector<Tap> taps(dest);
+		float scale = static_cast<float>(source) / dest;
+		for (int i = 0; i < dest; i++)
+		{
+			Tap& tap = taps[i];
+			if (mode != MipMode::Kaiser)
+			{
+				// every source pixel lands in exactly one destination pixel
+				tap.first = i * source / dest;
+				int last = (i + 1) * source / dest;
+				tap.weights.assign(std::max(last - tap.first, 1), 1.0f);
+			}
+			else
+			{
+				// two lobes either side, measured in destination pixels
+				const float radius = 2;
+				const float beta = 4;
+				float center = (i + 0.5f) * scale;
+				tap.first = static_cast<int>(std::floor(center - radius * scale));
+				int last = static_cast<int>(std::ceil(center + radius * scale));
+				for (int s = tap.first; s < last; s++)
+				{
+					float x = (s + 0.5f - center) / scale;
+					float r = x / radius;
+					float weight = 0;
+					if (std::abs(r) < 1)
+						weight = Sinc(x) * BesselI0(beta * std::sqrt(1 - r * r)) / BesselI0(beta);
+					tap.weights.push_back(weight);
+				}
+			}
+
+			float total = 0;
+			for (float w : tap.weights)
+				total += w;
+			for (float& w : tap.weights)
+				w /= total;
+		}
+		return taps;
+	}
+}
+
+int Mipmaps::LevelCount(int w, int h)
+{
+	int levels = 1;
+	while (w > 1 || h > 1)
+	{
+		w = std::max(w / 2, 1);
+		h = std::max(h / 2, 1);
+		levels++;
+	}
+	return levels;
+}
+
+size_t Mipmaps::ChainBytes(int w, int h)
+{
+	size_t bytes = static_cast<size_t>(w) * h * 4;
+	while (w > 1 || h > 1)
+	{
+		w = std::max(w / 2, 1);
+		h = std::max(h / 2, 1);
+		bytes += static_cast<size_t>(w) * h * 4;
+	}
+	return bytes;
+}
+
+void Mipmaps::Downsample(MipMode mode, const unsigned char* rgba, int w, int h, MipLevel& out)
+{
+	int dw = std::max(w / 2, 1);
+	int dh = std::max(h / 2, 1);
+	out.width = dw;
+	out.height = dh;
+	out.data.resize(static_cast<size_t>(dw) * dh * 4);
+
+	std::vector<Tap> across = Taps(mode, w, dw);
+	std::vector<Tap> down = Taps(mode, h, dh);
+
+	// across first, into a dw x h buffer
+	std::vector<float> rows(static_cast<size_t>(dw) * h * channels, 0.0f);
+	for (int y = 0; y < h; y++)
+	{
+		const unsigned char* row = rgba + static_cast<size_t>(y) * w * 4;
+		for (int x = 0; x < dw; x++)
+		{
+			const Tap& tap = across[x];
+			float* o = &rows[(static_cast<size_t>(y) * dw + x) * channels];
+			for (size_t t = 0; t < tap.weights.size(); t++)
+			{
+				// edges are clamped
+				const unsigned char* p = row + std::clamp(tap.first + static_cast<int>(t), 0, w - 1) * 4;
+				float weight = tap.weights[t];
+				float a = p[3] / 255.0f;
+				o[0] += weight * p[0] * a;
+				o[1] += weight * p[1] * a;
+				o[2] += weight * p[2] * a;
+				o[3] += weight * p[3];
+				o[4] += weight * p[0];
+				o[5] += weight * p[1];
+				o[6] += weight * p[2];
+			}
+		}
+	}
+
+	// then down
+	float sum[channels];
+	for (int y = 0; y < dh; y++)
+	{
+		const Tap& tap = down[y];
+		for (int x = 0; x < dw; x++)
+		{
+			std::fill(sum, sum + channels, 0.0f);
+			for (size_t t = 0; t < tap.weights.size(); t++)
+			{
+				const float* p = &rows[(static_cast<size_t>(std::clamp(tap.first + static_cast<int>(t), 0, h - 1)) * dw + x) * channels];
+				float weight = tap.weights[t];
+				for (int c = 0; c < channels; c++)
+					sum[c] += weight * p[c];
+			}
+
+			unsigned char* o = &out.data[(static_cast<size_t>(y) * dw + x) * 4];
+			float alpha = std::clamp(sum[3], 0.0f, 255.0f);
+			for (int c = 0; c < 3; c++)
+			{
+				// back to straight alpha, unless nothing here is visible
+				float colour = alpha >= 0.5f ? sum[c] * 255.0f / alpha : sum[c + 4];
+				o[c] = static_cast<unsigned char>(std::clamp(colour, 0.0f, 255.0f) + 0.5f);
+			}
+			o[3] = static_cast<unsigned char>(alpha + 0.5f);
+		}
+	}
+}
+
+std::vector<MipLevel> Mipmaps::Chain(MipMode mode, const unsigned char* rgba, int w, int h)
+{
+	std::vector<MipLevel> levels;
+	if ((mode != MipMode::Box && mode != MipMode::Kaiser) || rgba == NULL)
+		return levels;
+
+	levels.reserve(LevelCount(w, h) - 1);
+	while (w > 1 || h > 1)
+	{
+		const unsigned char* source = levels.size() == 0 ? rgba : levels.back().data.data();
+		MipLevel level;
+		Downsample(mode, source, w, h, level);
+		w = level.width;
+		h = level.height;
+		levels.push_back(std::move(level));
+	}
+	return levels;
+}
+
+#endif // !MIPMAPS_CPP
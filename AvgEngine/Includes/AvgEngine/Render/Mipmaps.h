@@ -0,0 +1,88 @@
+/*
+	Copyright 2021-2023 AvgEngine - Kade
+
+	Use of this source code without explict permission from owner is strictly prohibited.
+*/
+
+#ifndef MIPMAPS_H
+#define MIPMAPS_H
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace AvgEngine::Render
+{
+	/**
+	 * \brief How a texture's mip chain gets made
+	 */
+	enum class MipMode
+	{
+		/**
+		 * \brief No mips, minification samples the full size image (aliases when scaled down a lot)
+		 */
+		None = 0,
+		/**
+		 * \brief glGenerateMipmap on the GL thread (fast, the filter is up to the driver)
+		 */
+		Hardware,
+		/**
+		 * \brief A 2x2 box filter on the CPU (can be done on TextureLoader's worker threads)
+		 */
+		Box,
+		/**
+		 * \brief A Kaiser windowed sinc on the CPU (sharper than box, costs more to make)
+		 */
+		Kaiser
+	};
+
+	/**
+	 * \brief One RGBA mip level
+	 */
+	struct MipLevel
+	{
+		int width = 0, height = 0;
+		std::vector<unsigned char> data;
+	};
+
+	/**
+	 * \brief Builds mip chains on the CPU. None of this touches OpenGL, so it's fine on any thread (and in tools).
+	 * Colour is averaged weighted by alpha, so transparent pixels don't bleed dark edges into sprites.
+	 */
+	class Mipmaps
+	{
+	public:
+		/**
+		 * \brief How many levels a full chain has, counting the image itself (down to 1x1)
+		 */
+		static int LevelCount(int w, int h);
+
+		/**
+		 * \brief Halves an image (odd sizes round down, and the extra row/column is folded into the last pixel)
+		 * \param mode Box or Kaiser
+		 * \param rgba The pixels (w * h * 4)
+		 * \param w The width
+		 * \param h The height
+		 * \param out The next level
+		 */
+		static void Downsample(MipMode mode, const unsigned char* rgba, int w, int h, MipLevel& out);
+
+		/**
+		 * \brief Builds every level below the image
+		 * \param mode Box or Kaiser (anything else gives no levels)
+		 * \param rgba The pixels (w * h * 4)
+		 * \param w The width
+		 * \param h The height
+		 * \return Levels 1 and down, biggest first
+		 */
+		static std::vector<MipLevel> Chain(MipMode mode, const unsigned char* rgba, int w, int h);
+
+		/**
+		 * \brief How many bytes a full RGBA chain takes up, counting the image itself
+		 */
+		static size_t ChainBytes(int w, int h);
+	};
+}
+
+#endif // !MIPMAPS_H
@@ -0,0 +1,64 @@
+/*
+	Copyright 2021-2023 AvgEngine - Kade
+
+	Use of this source code without explict permission from owner is strictly prohibited.
+*/
+
+#include <AvgEngine/Render/OpenGL/Extensions.h>
+
+#include <GLFW/glfw3.h>
+
+// glad is generated for 3.2, so these aren't in it
+#ifndef GL_NUM_PROGRAM_BINARY_FORMATS
+#define GL_NUM_PROGRAM_BINARY_FORMATS 0x87FE
+#endif
+
+using namespace AvgEngine::OpenGL;
+
+#ifndef EXTENSIONS_CPP
+#define EXTENSIONS_CPP
+
+void Extensions::Load()
+{
+	glGetIntegerv(GL_MAJOR_VERSION, &major);
+	glGetIntegerv(GL_MINOR_VERSION, &minor);
+
+	extensions.clear();
+	GLint count = 0;
+	glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+	for (GLint i = 0; i < count; i++)
+	{
+		const GLubyte* name = glGetStringi(GL_EXTENSIONS, i);
+		if (name != NULL)
+			extensions.insert(reinterpret_cast<const char*>(name));
+	}
+
+	// core in 3.3, before that it's ARB_instanced_arrays
+	vertexAttribDivisor = NULL;
+	if (AtLeast(3, 3))
+		vertexAttribDivisor = reinterpret_cast<VertexAttribDivisorProc>(glfwGetProcAddress("glVertexAttribDivisor"));
+	if (vertexAttribDivisor == NULL && Has("GL_ARB_instanced_arrays"))
+		vertexAttribDivisor = reinterpret_cast<VertexAttribDivisorProc>(glfwGetProcAddress("glVertexAttribDivisorARB"));
+
+	// core in 4.1, the ARB version has the same names. Drivers can support it and still have no formats to save in.
+	getProgramBinary = NULL;
+	programBinary = NULL;
+	programParameteri = NULL;
+	GLint formats = 0;
+	if (AtLeast(4, 1) || Has("GL_ARB_get_program_binary"))
+		glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+	if (formats > 0)
+	{
+		getProgramBinary = reinterpret_cast<GetProgramBinaryProc>(glfwGetProcAddress("glGetProgramBinary"));
+		programBinary = reinterpret_cast<ProgramBinaryProc>(glfwGetProcAddress("glProgramBinary"));
+		programParameteri = reinterpret_cast<ProgramParameteriProc>(glfwGetProcAddress("glProgramParameteri"));
+		if (getProgramBinary == NULL || programBinary == NULL || programParameteri == NULL)
+		{
+			getProgramBinary = NULL;
+			programBinary = NULL;
+			programParameteri = NULL;
+		}
+	}
+}
+
+#endif // !EXTENSIONS_CPP
@@ -0,0 +1,72 @@
+/*
+	Copyright 2021-2023 AvgEngine - Kade
+
+	Use of this source code without explict permission from owner is strictly prohibited.
+*/
+
+#ifndef EXTENSIONS_H
+#define EXTENSIONS_H
+
+#pragma once
+
+#include <Glad/glad.h>
+#include <string>
+#include <unordered_set>
+
+namespace AvgEngine::OpenGL
+{
+	/**
+	 * \brief What the context supports past GL 3.2 (the version glad is generated for, so it doesn't know about any of this).
+	 * Load has to be called on the GL thread once the context is current.
+	 */
+	class Extensions
+	{
+	public:
+		typedef void (APIENTRY* VertexAttribDivisorProc)(GLuint index, GLuint divisor);
+		typedef void (APIENTRY* GetProgramBinaryProc)(GLuint program, GLsizei bufSize, GLsizei* length, GLenum* binaryFormat, void* binary);
+		typedef void (APIENTRY* ProgramBinaryProc)(GLuint program, GLenum binaryFormat, const void* binary, GLsizei length);
+		typedef void (APIENTRY* ProgramParameteriProc)(GLuint program, GLenum pname, GLint value);
+
+		static inline int major = 0;
+		static inline int minor = 0;
+
+		/**
+		 * \brief glVertexAttribDivisor (or the ARB version), NULL if instancing isn't supported
+		 */
+		static inline VertexAttribDivisorProc vertexAttribDivisor = NULL;
+
+		/**
+		 * \brief glGetProgramBinary, glProgramBinary and glProgramParameteri (core in 4.1, before that ARB_get_program_binary), NULL if program binaries aren't supported
+		 * or the driver has no binary formats
+		 */
+		static inline GetProgramBinaryProc getProgramBinary = NULL;
+		static inline ProgramBinaryProc programBinary = NULL;
+		static inline ProgramParameteriProc programParameteri = NULL;
+
+		/**
+		 * \brief Queries the version and extension list, and loads the functions above
+		 */
+		static void Load();
+
+		/**
+		 * \brief If the context has an extension (e.g. "GL_ARB_instanced_arrays")
+		 */
+		static bool Has(const std::string& name)
+		{
+			return extensions.contains(name);
+		}
+
+		/**
+		 * \brief If the context's version is at least major.minor
+		 */
+		static bool AtLeast(int _major, int _minor)
+		{
+			return major > _major || (major == _major && minor >= _minor);
+		}
+
+	private:
+		static inline std::unordered_set<std::string> extensions{};
+	};
+}
+
+#endif // !EXTENSIONS_H
@@ -0,0 +1,201 @@
+/*
+	Copyright 2021-2023 AvgEngine - Kade
+
+	Use of this source code without explict permission from owner is strictly prohibited.
+*/
+
+#include <AvgEngine/Render/OpenGL/ProgramCache.h>
+#include <AvgEngine/Render/OpenGL/Extensions.h>
+#include <AvgEngine/Utils/Logging.h>
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+// glad is generated for 3.2, so these aren't in it
+#ifndef GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#endif
+#ifndef GL_PROGRAM_BINARY_LENGTH
+#define GL_PROGRAM_BINARY_LENGTH 0x8741
+#endif
+
+using namespace AvgEngine::OpenGL;
+
+#ifndef PROGRAMCACHE_CPP
+#define PROGRAMCACHE_CPP
+
+namespace
+{
+	const char magic[4] = { 'A', 'V', 'G', 'P' };
+	const uint32_t fileVersion = 1;
+
+	// FNV-1a
+	uint64_t Hash(const std::string& text, uint64_t hash = 14695981039346656037ull)
+	{
+		for (unsigned char c : text)
+		{
+			hash ^= c;
+			hash *= 1099511628211ull;
+		}
+		return hash;
+	}
+
+	template <typename T>
+	void Write(std::ofstream& file, const T& value)
+	{
+		file.write(reinterpret_cast<const char*>(&value), sizeof(T));
+	}
+
+	template <typename T>
+	bool Read(std::ifstream& file, T& value)
+	{
+		return static_cast<bool>(file.read(reinterpret_cast<char*>(&value), sizeof(T)));
+	}
+}
+
+bool ProgramCache::Available()
+{
+	return enabled && Extensions::programBinary != NULL;
+}
+
+const std::string& ProgramCache::Driver()
+{
+	static std::string driver = "";
+	if (driver.size() == 0)
+	{
+		auto get = [](GLenum name) {
+			const GLubyte* value = glGetString(name);
+			return value != NULL ? std::string(reinterpret_cast<const char*>(value)) : std::string("?");
+		};
+		driver = get(GL_VENDOR) + "|" + get(GL_RENDERER) + "|" + get(GL_VERSION);
+	}
+	return driver;
+}
+
+uint64_t ProgramCache::Key(const std::string& vertex, const std::string& fragment)
+{
+	// the separator keeps "ab" + "c" and "a" + "bc" apart
+	uint64_t hash = Hash(vertex);
+	hash = Hash("\n--\n", hash);
+	hash = Hash(fragment, hash);
+	return Hash(Driver(), hash);
+}
+
+std::string ProgramCache::PathFor(uint64_t key)
+{
+	char name[32];
+	snprintf(name, sizeof(name), "%016llx.bin", static_cast<unsigned long long>(key));
+	return (std::filesystem::path(directory) / name).string();
+}
+
+bool ProgramCache::Load(GLuint program, uint64_t key)
+{
+	if (!Available())
+		return false;
+
+	std::string path = PathFor(key);
+	std::ifstream file(path, std::ios::binary);
+	if (!file.is_open())
+	{
+		misses++;
+		return false;
+	}
+
+	char fileMagic[4]{};
+	uint32_t version = 0;
+	uint64_t fileKey = 0;
+	uint32_t driverLength = 0;
+	bool ok = file.read(fileMagic, 4) && Read(file, version) && Read(file, fileKey) && Read(file, driverLength);
+	ok = ok && memcmp(fileMagic, magic, 4) == 0 && version == fileVersion && fileKey == key && driverLength == Driver().size();
+
+	std::string driver(driverLength, '\0');
+	uint32_t format = 0;
+	uint32_t length = 0;
+	std::vector<char> binary;
+	if (ok)
+		ok = file.read(driver.data(), driverLength) && driver == Driver() && Read(file, format) && Read(file, length) && length != 0;
+	if (ok)
+	{
+		binary.resize(length);
+		ok = static_cast<bool>(file.read(binary.data(), length));
+	}
+	file.close();
+
+	GLint linked = GL_FALSE;
+	if (ok)
+	{
+		Extensions::programBinary(program, format, binary.data(), static_cast<GLsizei>(length));
+		glGetProgramiv(program, GL_LINK_STATUS, &linked);
+	}
+
+	if (linked != GL_TRUE)
+	{
+		// stale (a driver update, or a different GPU), it gets replaced once this compiles
+		Logging::writeLog("[ProgramCache] [Warning] Couldn't use cached program " + path + ", compiling it instead");
+		std::error_code error;
+		std::filesystem::remove(path, error);
+		misses++;
+		return false;
+	}
+
+	hits++;
+	return true;
+}
+
+void ProgramCache::PrepareForSave(GLuint program)
+{
+	if (Available())
+		Extensions::programParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+}
+
+void ProgramCache::Save(GLuint program, uint64_t key)
+{
+	if (!Available())
+		return;
+
+	GLint linked = GL_FALSE;
+	glGetProgramiv(program, GL_LINK_STATUS, &linked);
+	GLint length = 0;
+	glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+	if (linked != GL_TRUE || length <= 0)
+		return;
+
+	std::vector<char> binary(length);
+	GLenum format = 0;
+	GLsizei written = 0;
+	Extensions::getProgramBinary(program, length, &written, &format, binary.data());
+	if (written <= 0)
+		return;
+
+	std::error_code error;
+	std::filesystem::create_directories(directory, error);
+
+	std::string path = PathFor(key);
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	if (!file.is_open())
+	{
+		Logging::writeLog("[ProgramCache] [Warning] Couldn't write " + path);
+		return;
+	}
+	const std::string& driver = Driver();
+	file.write(magic, 4);
+	Write(file, fileVersion);
+	Write(file, key);
+	Write(file, static_cast<uint32_t>(driver.size()));
+	file.write(driver.data(), driver.size());
+	Write(file, static_cast<uint32_t>(format));
+	Write(file, static_cast<uint32_t>(written));
+	file.write(binary.data(), written);
+}
+
+void ProgramCache::Clear()
+{
+	std::error_code error;
+	for (const auto& entry : std::filesystem::directory_iterator(directory, error))
+		if (entry.is_regular_file() && entry.path().extension() == ".bin")
+			std::filesystem::remove(entry.path(), error);
+}
+
+#endif // !PROGRAMCACHE_CPP
@@ -0,0 +1,82 @@
+/*
+	Copyright 2021-2023 AvgEngine - Kade
+
+	Use of this source code without explict permission from owner is strictly prohibited.
+*/
+
+#ifndef PROGRAMCACHE_H
+#define PROGRAMCACHE_H
+
+#pragma once
+
+#include <Glad/glad.h>
+#include <cstdint>
+#include <string>
+
+namespace AvgEngine::OpenGL
+{
+	/**
+	 * \brief Keeps linked shader programs on disk (glGetProgramBinary), so later launches can skip compiling them.
+	 * Programs are keyed on a hash of their source and the driver (vendor, renderer and version), and anything that doesn't match
+	 * or won't load is compiled from scratch like normal. Does nothing if the driver can't save program binaries (see Extensions).
+	 */
+	class ProgramCache
+	{
+	public:
+		/**
+		 * \brief If programs are loaded from (and saved to) the cache
+		 */
+		static inline bool enabled = true;
+
+		/**
+		 * \brief Where the binaries go
+		 */
+		static inline std::string directory = "Cache/Shaders";
+
+		static inline int hits = 0;
+		static inline int misses = 0;
+
+		/**
+		 * \brief If the cache can be used (it's enabled and the driver supports program binaries)
+		 */
+		static bool Available();
+
+		/**
+		 * \brief Hashes a program's source (everything that decides what it links to)
+		 */
+		static uint64_t Key(const std::string& vertex, const std::string& fragment);
+
+		/**
+		 * \brief Loads a cached binary into a program
+		 * \param program A program with nothing attached
+		 * \param key The program's key
+		 * \return If it loaded and linked (if not, the program should be compiled like normal)
+		 */
+		static bool Load(GLuint program, uint64_t key);
+
+		/**
+		 * \brief Saves a linked program's binary (it should have been linked with the retrievable hint, see PrepareForSave)
+		 */
+		static void Save(GLuint program, uint64_t key);
+
+		/**
+		 * \brief Tells the driver a program's binary will be read back, has to be called before linking it
+		 */
+		static void PrepareForSave(GLuint program);
+
+		/**
+		 * \brief Deletes every cached binary
+		 */
+		static void Clear();
+
+	private:
+		/**
+		 * \brief The driver's vendor, renderer and version (binaries only load on the driver that made them)
+		 */
+		static const std::string& Driver();
+
+		static std::string PathFor(uint64_t key);
+	};
+}
+
+#endif // !PROGRAMCACHE_H
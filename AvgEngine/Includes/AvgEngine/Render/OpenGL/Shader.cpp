@@ -7,36 +7,63 @@
 #include <Glad/glad.h>
 
 #include <AvgEngine/Render/OpenGL/Shader.h>
+#include <AvgEngine/Render/OpenGL/ProgramCache.h>
+#include <AvgEngine/Render/OpenGL/StateCache.h>
+
+#include <regex>
 using namespace AvgEngine::OpenGL;
 
 #ifndef SHADER_CPP
 #define SHADER_CPP
 
-int Shader::GetUniformLocation(std::string loc)
+namespace
 {
-	//Use previously defined location
-	auto key_loc = uniform_map.find(loc);
-	if (key_loc != uniform_map.end())
-		return key_loc->second;
-
-	//Find and remember location
-	GLint uniform_loc = glGetUniformLocation(program, loc.c_str());
-	if (uniform_loc == -1)
+	/**
+	 * \brief Blanks out // and block comments (keeping newlines), so a commented out declaration doesn't count
+	 */
+	std::string stripComments(const std::string& src)
+	{
+		std::string out = src;
+		size_t i = 0;
+		while (i < out.size())
+		{
+			if (out.compare(i, 2, "//") == 0)
+			{
+				while (i < out.size() && out[i] != '\n')
+					out[i++] = ' ';
+			}
+			else if (out.compare(i, 2, "/*") == 0)
+			{
+				size_t end = out.find("*/", i + 2);
+				end = end == std::string::npos ? out.size() : end + 2;
+				for (; i < end; i++)
+					if (out[i] != '\n')
+						out[i] = ' ';
+			}
+			else
+				i++;
+		}
+		return out;
+	}
+
+	/**
+	 * \brief If the source declares a uniform with this type and name (any spacing or precision, and in a list like "uniform float a, b;")
+	 */
+	bool declaresUniform(const std::string& src, const std::string& type, const std::string& name)
 	{
-		return -1;
+		std::regex declaration("\\buniform\\s+(?:(?:lowp|mediump|highp)\\s+)?" + type + "\\s+(?:\\w+\\s*(?:\\[[^\\]]*\\]\\s*)?,\\s*)*" + name + "\\b");
+		return std::regex_search(src, declaration);
 	}
-	uniform_map[loc] = uniform_loc;
-	return uniform_loc;
 }
 
 void Shader::GL_Use()
 {
-	glUseProgram(program);
+	StateCache::UseProgram(program);
 }
 
 Shader::~Shader()
 {
-	glDeleteProgram(this->program);
+	StateCache::DeleteProgram(this->program);
 	glDeleteShader(this->vertex);
 	glDeleteShader(this->fragment);
 }
@@ -44,7 +71,7 @@ Shader::~Shader()
 void Shader::GL_CompileShader(const char* src_vert, const char* src_frag)
 {
 
-	glDeleteProgram(this->program);
+	StateCache::DeleteProgram(this->program);
 	glDeleteShader(this->vertex);
 	glDeleteShader(this->fragment);
 	// defaults
@@ -57,7 +84,30 @@ void Shader::GL_CompileShader(const char* src_vert, const char* src_frag)
 
 	std::string srcVertStr = std::string(src_vert);
 	std::string srcFragStr = std::string(src_frag);
-	std::string precompiled = "#version 150 core\nuniform float iTime;\n";
+	// shaders that declare u_projection or iTime themselves keep them as plain uniforms, the rest comes from the frame block.
+	// a member the shader has is swapped for a placeholder of the same type, so the others stay where FrameBlock puts them
+	std::string vertCode = stripComments(srcVertStr);
+	std::string fragCode = stripComments(srcFragStr);
+	auto declares = [&](const std::string& type, const std::string& name) {
+		return declaresUniform(vertCode, type, name) || declaresUniform(fragCode, type, name);
+	};
+	ownProjection = declares("mat4", "u_projection");
+	bool ownTime = declares("float", "iTime");
+	std::string precompiled = "#version 150 core\n";
+	if (useFrameBlock && (!ownProjection || !ownTime))
+	{
+		precompiled += "layout(std140) uniform FrameBlock\n{\n";
+		precompiled += ownProjection ? "\tmat4 frame_projection;\n" : "\tmat4 u_projection;\n";
+		precompiled += ownTime ? "\tfloat frame_time;\n" : "\tfloat iTime;\n";
+		precompiled += "};\n";
+	}
+	else
+	{
+		if (!ownProjection)
+			precompiled += "uniform mat4 u_projection;\n";
+		if (!ownTime)
+			precompiled += "uniform float iTime;\n";
+	}
 	std::string vertTogether = precompiled + srcVertStr;
 	std::string fragTogether = precompiled + srcFragStr;
 	const char* srcVert = vertTogether.c_str();
@@ -66,33 +116,72 @@ void Shader::GL_CompileShader(const char* src_vert, const char* src_frag)
 	//Create shader
 	GLint shader_status;
 	program = glCreateProgram();
+	vertex = 0;
+	fragment = 0;
+
+	// the attribute locations are baked into a saved program, so they're part of its key
+	static const char* attributes[] = { "v_position", "v_uv", "v_colour", "i_dst", "i_src", "i_colour", "i_params" };
+	std::string layout = "";
+	for (const char* attribute : attributes)
+		layout += std::string(attribute) + ";";
+	uint64_t key = ProgramCache::Available() ? ProgramCache::Key(layout + vertTogether, fragTogether) : 0;
+
+	if (ProgramCache::Load(this->program, key))
+		shader_status = GL_TRUE;
+	else
+	{
+		//Compile vertex shader
+		vertex = glCreateShader(GL_VERTEX_SHADER);
+		glShaderSource(vertex, 1, &srcVert, NULL);
+		glCompileShader(this->vertex);
 
-	//Compile vertex shader
-	vertex = glCreateShader(GL_VERTEX_SHADER);
-	glShaderSource(vertex, 1, &srcVert, NULL);
-	glCompileShader(this->vertex);
+		glGetShaderiv(this->vertex, GL_COMPILE_STATUS, &shader_status);
 
-	glGetShaderiv(this->vertex, GL_COMPILE_STATUS, &shader_status);
 
+		//Compile fragment shader
+		this->fragment = glCreateShader(GL_FRAGMENT_SHADER);
+		glShaderSource(this->fragment, 1, &srcFrag, NULL);
+		glCompileShader(this->fragment);
 
-	//Compile fragment shader
-	this->fragment = glCreateShader(GL_FRAGMENT_SHADER);
-	glShaderSource(this->fragment, 1, &srcFrag, NULL);
-	glCompileShader(this->fragment);
+		glGetShaderiv(this->fragment, GL_COMPILE_STATUS, &shader_status);
 
-	glGetShaderiv(this->fragment, GL_COMPILE_STATUS, &shader_status);
+		//Attach and link
+		glAttachShader(this->program, this->vertex);
+		glAttachShader(this->program, this->fragment);
 
-	//Attach and link
-	glAttachShader(this->program, this->vertex);
-	glAttachShader(this->program, this->fragment);
+		for (GLuint i = 0; i < sizeof(attributes) / sizeof(attributes[0]); i++)
+			glBindAttribLocation(this->program, i, attributes[i]);
 
-	glBindAttribLocation(this->program, 0, "v_position");
-	glBindAttribLocation(this->program, 1, "v_uv");
-	glBindAttribLocation(this->program, 2, "v_colour");
+		ProgramCache::PrepareForSave(this->program);
+		glLinkProgram(this->program);
 
-	glLinkProgram(this->program);
+		glGetProgramiv(this->program, GL_LINK_STATUS, &shader_status);
 
-	glGetProgramiv(this->program, GL_LINK_STATUS, &shader_status);
+		if (shader_status == GL_TRUE)
+			ProgramCache::Save(this->program, key);
+	}
+
+	GLuint blockIndex = glGetUniformBlockIndex(this->program, "FrameBlock");
+	frameBlock = blockIndex != GL_INVALID_INDEX;
+	if (frameBlock)
+		glUniformBlockBinding(this->program, blockIndex, frameBlockBinding);
+
+	// look every active uniform up now, so setting them later never has to ask GL
+	locations.assign(uniformNames.size(), -2);
+	GLint active = 0;
+	glGetProgramiv(this->program, GL_ACTIVE_UNIFORMS, &active);
+	char name[256];
+	for (GLint i = 0; i < active; i++)
+	{
+		GLsizei length = 0;
+		GLint size = 0;
+		GLenum type = 0;
+		glGetActiveUniform(this->program, i, sizeof(name), &length, &size, &type, name);
+		UniformHandle handle = Handle(std::string(name, length));
+		if (handle.id >= static_cast<int>(locations.size()))
+			locations.resize(uniformNames.size(), -2);
+		locations[handle.id] = glGetUniformLocation(this->program, name);
+	}
 
 }
 
@@ -144,10 +233,13 @@ void AvgEngine::OpenGL::Shader::uniform4f(int loc_id, float f0, float f1, float
 	glUniform4f(loc_id, f0, f1, f2, f3);
 }
 
-void AvgEngine::OpenGL::Shader::setProject(glm::mat4 proj)
+bool AvgEngine::OpenGL::Shader::setProject(glm::mat4 proj)
 {
-	GL_Use();
-	glUniformMatrix4fv(glGetUniformLocation(this->program, "u_projection"), 1, GL_FALSE, &proj[0][0]);
+	if (frameBlock && !ownProjection)
+		return false;
+	static const UniformHandle projection = Handle("u_projection");
+	SetUniform(projection, proj);
+	return true;
 }
 
 #endif // !SHADER_CPP
\ No newline at end of file
@@ -12,6 +12,7 @@
 #include <Glad/glad.h>
 #include <iostream>
 #include <unordered_map>
+#include <vector>
 #include <fstream>
 #include <string>
 #include <Glm/gtc/matrix_transform.hpp>
@@ -24,13 +25,43 @@ namespace AvgEngine::OpenGL
 		in vec4 v_colour;
 		out vec2 f_uv;
 		out vec4 f_colour;
-		uniform mat4 u_projection;
 
 		void main()
 		{
 			f_uv = v_uv;
 			f_colour = v_colour;
 			gl_Position = u_projection * vec4(v_position.xy, 0.0, 1.0);
+		})";
+			static const char* instanced_shader_vert = R"(
+		in vec4 i_dst;
+		in vec4 i_src;
+		in vec4 i_colour;
+		in vec3 i_params; // scale, angle, center
+		out vec2 f_uv;
+		out vec4 f_colour;
+
+		void main()
+		{
+			// the shared quad indices go tl, bl, tr, br
+			vec2 corner = vec2(gl_VertexID / 2, gl_VertexID % 2);
+
+			vec4 d = i_dst;
+			if (i_params.z > 0.5)
+				d.xy += (d.zw * (1.0 - i_params.x)) / 2.0;
+			d.zw *= i_params.x;
+
+			vec2 pos = d.xy + corner * d.zw;
+			if (i_params.y != 0.0)
+			{
+				float a = radians(i_params.y);
+				vec2 c = d.xy + d.zw * 0.5;
+				vec2 t = pos - c;
+				pos = vec2(t.x * cos(a) - t.y * sin(a), t.x * sin(a) + t.y * cos(a)) + c;
+			}
+
+			f_uv = i_src.xy + corner * i_src.zw;
+			f_colour = i_colour;
+			gl_Position = u_projection * vec4(pos, 0.0, 1.0);
 		})";
 			static const char* generic_shader_frag = R"(
 		uniform sampler2D u_texture;
@@ -47,8 +78,67 @@ namespace AvgEngine::OpenGL
 			if (white >= 0.9)
 				o_colour = vec4(1,1,1,o_colour.a);
 				
+		})";
+
+			static const char* sdf_shader_frag = R"(
+		uniform sampler2D u_texture;
+		uniform float u_outline; // how far past the edge the outline reaches (in field units, 0-0.5)
+		uniform vec4 u_outlineColour;
+		uniform vec2 u_shadowOffset; // in uv
+		uniform vec4 u_shadowColour;
+		uniform float u_shadowSoftness;
+		in vec2 f_uv;
+		in vec4 f_colour;
+
+		out vec4 o_colour;
+
+		// a over b, both with straight alpha
+		vec4 over(vec4 a, vec4 b)
+		{
+			float alpha = a.a + b.a * (1.0 - a.a);
+			if (alpha <= 0.0)
+				return vec4(0.0);
+			return vec4((a.rgb * a.a + b.rgb * b.a * (1.0 - a.a)) / alpha, alpha);
+		}
+
+		void main()
+		{
+			// 0.5 is the glyph's edge
+			float d = texture(u_texture, f_uv).a;
+			float aa = max(fwidth(d), 0.0001);
+
+			vec4 fill = vec4(f_colour.rgb, f_colour.a * smoothstep(0.5 - aa, 0.5 + aa, d));
+
+			float outlineEdge = 0.5 - u_outline;
+			vec4 outline = vec4(u_outlineColour.rgb, u_outlineColour.a * f_colour.a * smoothstep(outlineEdge - aa, outlineEdge + aa, d));
+
+			float sd = texture(u_texture, f_uv - u_shadowOffset).a;
+			float soft = max(u_shadowSoftness, aa);
+			vec4 shadow = vec4(u_shadowColour.rgb, u_shadowColour.a * f_colour.a * smoothstep(outlineEdge - soft, outlineEdge + soft, sd));
+
+			o_colour = over(over(fill, outline), shadow);
+			if (o_colour.a == 0.0)
+				discard;
 		})";
 
+			/**
+			 * \brief A uniform's name, interned once so setting it after is just an index (get one with Shader::Handle)
+			 */
+			struct UniformHandle
+			{
+				int id = -1;
+			};
+
+			/**
+			 * \brief The std140 layout of the per frame uniform block every shader can read (u_projection and iTime)
+			 */
+			struct FrameBlock
+			{
+				glm::mat4 projection{};
+				float time = 0;
+				float padding[3]{};
+			};
+
 			/**
 			 * \brief The OpenGL Shader Class
 			 */
@@ -76,7 +166,44 @@ namespace AvgEngine::OpenGL
 				GLuint vertex = 0;
 				GLuint fragment = 0;
 
-				std::unordered_map<std::string, GLint> uniform_map;
+				/**
+				 * \brief Where the frame block is bound (Display keeps its buffer there)
+				 */
+				static const GLuint frameBlockBinding = 0;
+
+				/**
+				 * \brief If shaders read u_projection and iTime from the frame block instead of their own uniforms (shaders that declare either themselves use their own for that one)
+				 */
+				static inline bool useFrameBlock = true;
+
+				/**
+				 * \brief If this shader reads the frame block (for u_projection, iTime, or both)
+				 */
+				bool frameBlock = false;
+
+				/**
+				 * \brief If this shader declares its own u_projection (setProject only sets it for these, or when there's no frame block)
+				 */
+				bool ownProjection = false;
+
+				/**
+				 * \brief Uniform locations by handle id (-2 is not looked up yet)
+				 */
+				std::vector<GLint> locations;
+
+				/**
+				 * \brief Interns a uniform name. Handles are the same for every shader, so get them once (like in a static) and reuse them.
+				 */
+				static UniformHandle Handle(const std::string& name)
+				{
+					auto it = uniformIds.find(name);
+					if (it != uniformIds.end())
+						return { it->second };
+					int id = static_cast<int>(uniformNames.size());
+					uniformNames.push_back(name);
+					uniformIds[name] = id;
+					return { id };
+				}
 
 				Shader() {
 
@@ -125,63 +252,148 @@ namespace AvgEngine::OpenGL
 
 				void GL_Use();
 
-				GLint GetUniformLocation(std::string loc);
+				/**
+				 * \brief Gets a uniform's location (cached, the active uniforms are looked up when the shader is compiled)
+				 * \return The location, or -1 if the shader doesn't have it
+				 */
+				GLint GetUniformLocation(UniformHandle handle)
+				{
+					if (handle.id < 0)
+						return -1;
+					if (handle.id >= static_cast<int>(locations.size()))
+						locations.resize(uniformNames.size(), -2);
+					GLint& location = locations[handle.id];
+					if (location == -2)
+						location = glGetUniformLocation(program, uniformNames[handle.id].c_str());
+					return location;
+				}
+
+				GLint GetUniformLocation(const std::string& loc)
+				{
+					return GetUniformLocation(Handle(loc));
+				}
 
 				#define SETUNIFORM_GET_LOC_ID() \
 						GLint loc_id = GetUniformLocation(loc); \
 						if (loc_id == -1) \
 							return true;
 
-				bool SetUniform(std::string loc, int i0)
+				bool SetUniform(UniformHandle loc, int i0)
+				{
+					SETUNIFORM_GET_LOC_ID()
+					uniform1i(loc_id, i0);
+					return false;
+				}
+
+				bool SetUniform(UniformHandle loc, int i0, int i1)
+				{
+					SETUNIFORM_GET_LOC_ID()
+					uniform2i(loc_id, i0, i1);
+					return false;
+				}
+
+				bool SetUniform(UniformHandle loc, int i0, int i1, int i2)
+				{
+					SETUNIFORM_GET_LOC_ID()
+					uniform3i(loc_id, i0, i1, i2);
+					return false;
+				}
+
+				bool SetUniform(UniformHandle loc, int i0, int i1, int i2, int i3)
+				{
+					SETUNIFORM_GET_LOC_ID()
+					uniform4i(loc_id, i0, i1, i2, i3);
+					return false;
+				}
+
+				bool SetUniform(UniformHandle loc, float f0)
+				{
+					SETUNIFORM_GET_LOC_ID()
+					uniform1f(loc_id, f0);
+					return false;
+				}
+
+				bool SetUniform(UniformHandle loc, float f0, float f1)
+				{
+					SETUNIFORM_GET_LOC_ID()
+					uniform2f(loc_id, f0, f1);
+					return false;
+				}
+
+				bool SetUniform(UniformHandle loc, float f0, float f1, float f2)
+				{
+					SETUNIFORM_GET_LOC_ID()
+					uniform3f(loc_id, f0, f1, f2);
+					return false;
+				}
+
+				bool SetUniform(UniformHandle loc, float f0, float f1, float f2, float f3)
+				{
+					SETUNIFORM_GET_LOC_ID()
+					uniform4f(loc_id, f0, f1, f2, f3);
+					return false;
+				}
+
+				bool SetUniform(UniformHandle loc, glm::mat4 m)
+				{
+					SETUNIFORM_GET_LOC_ID()
+					GL_Use();
+					glUniformMatrix4fv(loc_id, 1, GL_FALSE, &m[0][0]);
+					return false;
+				}
+
+				// by name (interned on every call, use a handle for anything set every frame)
+
+				bool SetUniform(const std::string& loc, int i0)
 				{
 					SETUNIFORM_GET_LOC_ID()
 						uniform1i(loc_id, i0);
 					return false;
 				}
 
-				bool SetUniform(std::string loc, int i0, int i1)
+				bool SetUniform(const std::string& loc, int i0, int i1)
 				{
 					SETUNIFORM_GET_LOC_ID()
 					uniform2i(loc_id, i0, i1);
 					return false;
 				}
 
-				bool SetUniform(std::string loc, int i0, int i1, int i2)
+				bool SetUniform(const std::string& loc, int i0, int i1, int i2)
 				{
 					SETUNIFORM_GET_LOC_ID()
 					uniform3i(loc_id, i0, i1, i2);
 					return false;
 				}
 
-				bool SetUniform(std::string loc, int i0, int i1, int i2, int i3)
+				bool SetUniform(const std::string& loc, int i0, int i1, int i2, int i3)
 				{
 					SETUNIFORM_GET_LOC_ID()
 					uniform4i(loc_id, i0, i1, i2, i3);
 					return false;
 				}
 
-				bool SetUniform(std::string loc, float f0)
+				bool SetUniform(const std::string& loc, float f0)
 				{
 					SETUNIFORM_GET_LOC_ID()
 					uniform1f(loc_id, f0);
 					return false;
 				}
 
-				bool SetUniform(std::string loc, float f0, float f1)
+				bool SetUniform(const std::string& loc, float f0, float f1)
 				{
 					SETUNIFORM_GET_LOC_ID()
 					uniform2f(loc_id, f0, f1);
 					return false;
 				}
 
-				bool SetUniform(std::string loc, float f0, float f1, float f2)
+				bool SetUniform(const std::string& loc, float f0, float f1, float f2)
 				{
 					SETUNIFORM_GET_LOC_ID()
 					uniform3f(loc_id, f0, f1, f2);
 					return false;
 				}
 
-				bool SetUniform(std::string loc, float f0, float f1, float f2, float f3)
+				bool SetUniform(const std::string& loc, float f0, float f1, float f2, float f3)
 				{
 					SETUNIFORM_GET_LOC_ID()
 					uniform4f(loc_id, f0, f1, f2, f3);
@@ -190,7 +402,18 @@ namespace AvgEngine::OpenGL
 
 				void GL_CompileShader(const char* src_vert, const char* src_frag);
 
-				void setProject(glm::mat4 proj);
+				/**
+				 * \brief Sets u_projection, unless the shader reads it from the frame block (see frameBlock and ownProjection). Those shaders are left alone on purpose,
+				 * since they all share the projection Display::SetProject uploads, and a per-shader one would need the shader to declare
+				 * "uniform mat4 u_projection;" itself.
+				 * \param proj The projection matrix
+				 * \return If u_projection was set (false for frame block shaders)
+				 */
+				bool setProject(glm::mat4 proj);
+
+			private:
+				static inline std::unordered_map<std::string, int> uniformIds{};
+				static inline std::vector<std::string> uniformNames{};
 			};
 }
 
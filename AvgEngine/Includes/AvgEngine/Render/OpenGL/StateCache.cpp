@@ -0,0 +1,43 @@
+/*
+	Copyright 2021-2023 AvgEngine - Kade
+
+	Use of this source code without explict permission from owner is strictly prohibited.
+*/
+
+#include <AvgEngine/Render/OpenGL/StateCache.h>
+
+using namespace AvgEngine::OpenGL;
+
+#ifndef STATECACHE_CPP
+#define STATECACHE_CPP
+
+void StateCache::DeleteTexture(GLuint texture)
+{
+	glDeleteTextures(1, &texture);
+	for (GLuint& bound : state.textures)
+		if (bound == texture)
+			bound = 0;
+}
+
+void StateCache::DeleteProgram(GLuint program)
+{
+	glDeleteProgram(program);
+	if (state.program == program)
+		state.program = ~0u;
+}
+
+void StateCache::Invalidate()
+{
+	GLint unit = GL_TEXTURE0;
+	glGetIntegerv(GL_ACTIVE_TEXTURE, &unit);
+	state = State();
+	state.unit = unit - GL_TEXTURE0;
+}
+
+void StateCache::EndFrame()
+{
+	lastFrame = frame;
+	frame = {};
+}
+
+#endif // !STATECACHE_CPP
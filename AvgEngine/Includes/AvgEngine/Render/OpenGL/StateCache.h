@@ -0,0 +1,189 @@
+/*
+	Copyright 2021-2023 AvgEngine - Kade
+
+	Use of this source code without explict permission from owner is strictly prohibited.
+*/
+
+#ifndef STATECACHE_H
+#define STATECACHE_H
+
+#pragma once
+
+#include <Glad/glad.h>
+
+namespace AvgEngine::OpenGL
+{
+	/**
+	 * \brief GL calls issued vs skipped because they wouldn't have changed anything
+	 */
+	struct StateCounters
+	{
+		int issued = 0;
+		int elided = 0;
+	};
+
+	/**
+	 * \brief Remembers what's bound (program, textures, VAO, buffers, scissor) so calls that wouldn't change anything are skipped.
+	 * Everything in the engine binds through this, so code that calls GL directly has to call Invalidate after.
+	 */
+	class StateCache
+	{
+	public:
+		/**
+		 * \brief If calls are skipped (when off everything is issued, the counters still count)
+		 */
+		static inline bool enabled = true;
+
+		/**
+		 * \brief The counters for the frame being drawn
+		 */
+		static inline StateCounters frame{};
+		/**
+		 * \brief The counters for the last whole frame (see EndFrame)
+		 */
+		static inline StateCounters lastFrame{};
+
+		static void UseProgram(GLuint program)
+		{
+			if (Skip(program == state.program))
+				return;
+			state.program = program;
+			glUseProgram(program);
+		}
+
+		static void ActiveTexture(int unit)
+		{
+			if (Skip(unit == state.unit))
+				return;
+			state.unit = unit;
+			glActiveTexture(GL_TEXTURE0 + unit);
+		}
+
+		/**
+		 * \brief Binds a GL_TEXTURE_2D to the active unit
+		 */
+		static void BindTexture(GLuint texture)
+		{
+			if (Skip(texture == state.textures[state.unit]))
+				return;
+			state.textures[state.unit] = texture;
+			glBindTexture(GL_TEXTURE_2D, texture);
+		}
+
+		static void BindVertexArray(GLuint vao)
+		{
+			if (Skip(vao == state.vao))
+				return;
+			state.vao = vao;
+			glBindVertexArray(vao);
+		}
+
+		/**
+		 * \brief Binds GL_ARRAY_BUFFER or GL_UNIFORM_BUFFER (GL_ELEMENT_ARRAY_BUFFER is part of the VAO, so bind that one directly)
+		 */
+		static void BindBuffer(GLenum target, GLuint buffer)
+		{
+			GLuint& bound = target == GL_UNIFORM_BUFFER ? state.uniformBuffer : state.arrayBuffer;
+			if (Skip(buffer == bound))
+				return;
+			bound = buffer;
+			glBindBuffer(target, buffer);
+		}
+
+		/**
+		 * \brief glBindBufferBase for uniform buffers (it binds the generic target too)
+		 */
+		static void BindBufferBase(GLuint index, GLuint buffer)
+		{
+			frame.issued++;
+			state.uniformBuffer = buffer;
+			glBindBufferBase(GL_UNIFORM_BUFFER, index, buffer);
+		}
+
+		static void ScissorTest(bool enable)
+		{
+			if (Skip(enable == state.scissorTest))
+				return;
+			state.scissorTest = enable;
+			if (enable)
+				glEnable(GL_SCISSOR_TEST);
+			else
+				glDisable(GL_SCISSOR_TEST);
+		}
+
+		static void Scissor(int x, int y, int w, int h)
+		{
+			if (Skip(x == state.scissor[0] && y == state.scissor[1] && w == state.scissor[2] && h == state.scissor[3]))
+				return;
+			state.scissor[0] = x;
+			state.scissor[1] = y;
+			state.scissor[2] = w;
+			state.scissor[3] = h;
+			glScissor(x, y, w, h);
+		}
+
+		/**
+		 * \brief Deletes a texture (GL unbinds it from every unit, so the cache forgets it too)
+		 */
+		static void DeleteTexture(GLuint texture);
+
+		/**
+		 * \brief Deletes a program (it stays in use until something else is, but the cache forgets it so its name can be reused)
+		 */
+		static void DeleteProgram(GLuint program);
+
+		/**
+		 * \brief Forgets everything, so the next call of each kind is always issued (for after code that calls GL directly)
+		 */
+		static void Invalidate();
+
+		/**
+		 * \brief Moves this frame's counters to lastFrame and starts counting again
+		 */
+		static void EndFrame();
+
+	private:
+		static const int units = 16;
+
+		/**
+		 * \brief What GL has bound (unknown values never match, so the first call always goes through)
+		 */
+		struct State
+		{
+			GLuint program = ~0u;
+			// the unit is always known, it's 0 until something changes it
+			int unit = 0;
+			GLuint textures[units];
+			GLuint vao = ~0u;
+			GLuint arrayBuffer = ~0u;
+			GLuint uniformBuffer = ~0u;
+			// neither, so the first one is always issued
+			int scissorTest = -1;
+			int scissor[4] = { -1, -1, -1, -1 };
+
+			State()
+			{
+				for (GLuint& texture : textures)
+					texture = ~0u;
+			}
+		};
+
+		static inline State state{};
+
+		/**
+		 * \brief Counts a call, and says if it can be skipped
+		 */
+		static bool Skip(bool same)
+		{
+			if (same && enabled)
+			{
+				frame.elided++;
+				return true;
+			}
+			frame.issued++;
+			return false;
+		}
+	};
+}
+
+#endif // !STATECACHE_H
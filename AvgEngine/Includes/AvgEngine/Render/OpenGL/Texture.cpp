@@ -8,8 +8,30 @@
 
 #include <AvgEngine/External/Image/imageinfo.hpp>
 #include <AvgEngine/External/Image/stbi.h>
+#include <AvgEngine/Render/OpenGL/Extensions.h>
+#include <AvgEngine/Render/OpenGL/StateCache.h>
+#include <AvgEngine/Utils/Logging.h>
 
 #include <Glad/glad.h>
+#include <cstdlib>
+#include <vector>
+
+// glad is generated for 3.2 without extensions, so these aren't in it
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT1_EXT 0x83F1
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+#ifndef GL_COMPRESSED_RGBA_BPTC_UNORM
+#define GL_COMPRESSED_RGBA_BPTC_UNORM 0x8E8C
+#endif
+#ifndef GL_COMPRESSED_RGB8_ETC2
+#define GL_COMPRESSED_RGB8_ETC2 0x9274
+#endif
+#ifndef GL_COMPRESSED_RGBA8_ETC2_EAC
+#define GL_COMPRESSED_RGBA8_ETC2_EAC 0x9278
+#endif
 
 using namespace AvgEngine::OpenGL;
 
@@ -35,8 +57,11 @@ bool validImage(std::string path)
 	return true;
 }
 
-Texture* Texture::createWithImage(std::string filePath)
+Texture* Texture::createWithImage(std::string filePath, bool keep, Render::MipMode mips)
 {
+	if (Render::BlockCompression::IsContainer(filePath))
+		return createWithCompressed(filePath);
+
 	if (!validImage(filePath) || filePath.find('.') == std::string::npos)
 	{
 		AvgEngine::OpenGL::Texture* tt = returnWhiteTexture();
@@ -52,17 +77,63 @@ Texture* Texture::createWithImage(std::string filePath)
 		return tt;
 	}
 
+	// made with the default when it was uploaded, while the pixels are still here
+	if (mips != t->mipMode)
+		t->BuildMips(mips);
+
+	// it's on the GPU now, the copy can go unless someone asked for it
+	if (!keep)
+		t->ReleasePixels();
+
 	return t;
 }
 
+Texture* Texture::createWithCompressed(std::string filePath)
+{
+	Render::CompressedImage image;
+	std::string error;
+	if (!Render::BlockCompression::Read(filePath, image, error))
+	{
+		Logging::writeLog("[Texture] [Error] Failed to load " + filePath + ", " + error);
+		return returnWhiteTexture();
+	}
+
+	Texture* t = new Texture(NULL, 1, 1);
+	t->SetCompressedData(image);
+	return t;
+}
+
+bool Texture::SupportsFormat(Render::BlockFormat format)
+{
+	switch (format)
+	{
+	case Render::BlockFormat::BC1:
+	case Render::BlockFormat::BC3:
+		return Extensions::Has("GL_EXT_texture_compression_s3tc");
+	case Render::BlockFormat::BC7:
+		return Extensions::AtLeast(4, 2) || Extensions::Has("GL_ARB_texture_compression_bptc");
+	case Render::BlockFormat::ETC2_RGB:
+	case Render::BlockFormat::ETC2_RGBA:
+		return Extensions::AtLeast(4, 3) || Extensions::Has("GL_ARB_ES3_compatibility");
+	default:
+		return false;
+	}
+}
+
 Texture* Texture::loadTextureFromData(char* data, size_t outLength)
 {
-	return External::stbi_h::stbi_load_memory(data, outLength);
+	Texture* t = External::stbi_h::stbi_load_memory(data, outLength);
+	t->fromSTBI = true;
+	if (!keepPixels)
+		t->ReleasePixels();
+	return t;
 }
 
 Texture* AvgEngine::OpenGL::Texture::loadTextureFromData(unsigned char* data, int w, int h)
 {
 	Texture* t = new Texture(data, w, h);
+	// the data is still the caller's, so don't hang on to a pointer that can go away
+	t->pixels = NULL;
 	return t;
 }
 
@@ -77,9 +148,42 @@ texData Texture::getTextureData(std::string filePath)
 
 void Texture::resizeTexture(int w, int h)
 {
-	glDeleteTextures(1, &id);
+	// the old pixels only fit if the size didn't change, otherwise the new storage starts empty
+	if (w != width || h != height)
+		ReleasePixels();
+	unsigned char* data = w == width && h == height ? Pixels() : NULL;
+	bool owned = fromSTBI;
+	StateCache::DeleteTexture(id);
 	glGenTextures(1, &id);
-	SetData(pixels, w, h);
+	SetData(data, w, h);
+	// they're still ours, SetData only hands out ownership for stb's buffers
+	fromSTBI = owned && data != NULL;
+}
+
+unsigned char* Texture::Pixels()
+{
+	if (pixels != NULL || width <= 0 || height <= 0)
+		return pixels;
+
+	// malloc'd so it can be freed the same way stb_image's are
+	unsigned char* data = static_cast<unsigned char*>(malloc(static_cast<size_t>(width) * height * 4));
+	if (data == NULL)
+		return NULL;
+
+	StateCache::BindTexture(id);
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
+
+	pixels = data;
+	fromSTBI = true;
+	return pixels;
+}
+
+void Texture::ReleasePixels()
+{
+	if (pixels != nullptr && fromSTBI)
+		External::stbi_h::stbi_free(pixels);
+	pixels = NULL;
 }
 
 
@@ -103,7 +207,7 @@ Texture::Texture(unsigned char* data, const unsigned int _width, const unsigned
 	width = _width;
 	height = _height;
 
-	glBindTexture(GL_TEXTURE_2D, id);
+	StateCache::BindTexture(id);
 	glEnable(GL_TEXTURE_2D);
 
 	glTexImage2DMultisample(GL_TEXTURE_2D_MULTISAMPLE, 4, GL_RGBA8,
@@ -113,14 +217,14 @@ Texture::Texture(unsigned char* data, const unsigned int _width, const unsigned
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 
-	glBindTexture(GL_TEXTURE_2D, 0);
+	StateCache::BindTexture(0);
 }
 
 
 Texture::~Texture()
 {
 	//Delete texture object
-	glDeleteTextures(1, &id);
+	StateCache::DeleteTexture(id);
 	if (pixels != nullptr && fromSTBI && width > 0 && height > 0)
 		External::stbi_h::stbi_free(pixels);
 }
@@ -128,29 +232,167 @@ Texture::~Texture()
 //Set texture data function
 bool Texture::SetData(unsigned char* data, const unsigned int _width, const unsigned int _height)
 {
+	// the buffer being replaced goes with it, and the new one belongs to the caller (the stb loads mark theirs after)
+	if (pixels != data)
+		ReleasePixels();
 	pixels = data;
+	fromSTBI = false;
 	width = _width;
 	height = _height;
+	compressedFormat = Render::BlockFormat::None;
+	gpuBytes = static_cast<size_t>(_width) * _height * 4;
 
-	glBindTexture(GL_TEXTURE_2D, id);
+	StateCache::BindTexture(id);
 	glEnable(GL_TEXTURE_2D);
 
 	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, _width, _height, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
 
 	//Set texture parameters
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	mipLevels = 1;
+
+	// the CPU filters need something to filter, empty textures can only have the driver's (empty) mips
+	if (mipMode == Render::MipMode::Hardware || (mipMode != Render::MipMode::None && pixels != NULL))
+		BuildMips(mipMode);
 
 	//Game::instance->createTexture(this);
 
 	return true;
 }
 
+bool Texture::SetSubData(unsigned char* data, int x, int y, int w, int h)
+{
+	StateCache::BindTexture(id);
+	glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, w, h, GL_RGBA, GL_UNSIGNED_BYTE, data);
+	return true;
+}
+
+void Texture::BuildMips(Render::MipMode mode)
+{
+	mipMode = mode;
+	if (compressedFormat != Render::BlockFormat::None)
+		return;
+
+	StateCache::BindTexture(id);
+	switch (mode)
+	{
+	case Render::MipMode::None:
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		mipLevels = 1;
+		gpuBytes = static_cast<size_t>(width) * height * 4;
+		break;
+	case Render::MipMode::Hardware:
+		mipLevels = Render::Mipmaps::LevelCount(width, height);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, mipLevels - 1);
+		glGenerateMipmap(GL_TEXTURE_2D);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, mipLevels > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+		gpuBytes = Render::Mipmaps::ChainBytes(width, height);
+		break;
+	default:
+	{
+		bool held = pixels != NULL;
+		unsigned char* data = Pixels();
+		if (data == NULL)
+			return;
+		std::vector<Render::MipLevel> levels = Render::Mipmaps::Chain(mode, data, width, height);
+		if (!held)
+			ReleasePixels();
+		SetMips(levels, mode);
+		break;
+	}
+	}
+}
+
+void Texture::SetMips(const std::vector<Render::MipLevel>& levels, Render::MipMode mode)
+{
+	mipMode = mode;
+	mipLevels = static_cast<int>(levels.size()) + 1;
+	gpuBytes = static_cast<size_t>(width) * height * 4;
+
+	StateCache::BindTexture(id);
+	for (int i = 0; i < static_cast<int>(levels.size()); i++)
+	{
+		const Render::MipLevel& level = levels[i];
+		glTexImage2D(GL_TEXTURE_2D, i + 1, GL_RGBA, level.width, level.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, level.data.data());
+		gpuBytes += level.data.size();
+	}
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, mipLevels - 1);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, mipLevels > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+}
+
+bool Texture::SetCompressedData(const Render::CompressedImage& image)
+{
+	if (image.levels.size() == 0)
+		return false;
+
+	ReleasePixels();
+	width = image.width;
+	height = image.height;
+	gpuBytes = 0;
+
+	GLenum format = 0;
+	switch (image.format)
+	{
+	case Render::BlockFormat::BC1:
+		format = GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;
+		break;
+	case Render::BlockFormat::BC3:
+		format = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+		break;
+	case Render::BlockFormat::BC7:
+		format = GL_COMPRESSED_RGBA_BPTC_UNORM;
+		break;
+	case Render::BlockFormat::ETC2_RGB:
+		format = GL_COMPRESSED_RGB8_ETC2;
+		break;
+	case Render::BlockFormat::ETC2_RGBA:
+		format = GL_COMPRESSED_RGBA8_ETC2_EAC;
+		break;
+	default:
+		break;
+	}
+	bool native = !decodeCompressed && format != 0 && SupportsFormat(image.format);
+	compressedFormat = native ? image.format : Render::BlockFormat::None;
+
+	StateCache::BindTexture(id);
+	std::vector<unsigned char> decoded;
+	int levels = static_cast<int>(image.levels.size());
+	for (int i = 0; i < levels; i++)
+	{
+		const Render::CompressedLevel& level = image.levels[i];
+		if (native)
+		{
+			glCompressedTexImage2D(GL_TEXTURE_2D, i, format, level.width, level.height, 0, static_cast<GLsizei>(level.data.size()), level.data.data());
+			gpuBytes += level.data.size();
+		}
+		else
+		{
+			// the GPU can't sample it, so it goes up as plain RGBA
+			decoded.resize(static_cast<size_t>(level.width) * level.height * 4);
+			Render::BlockCompression::Decode(image.format, level, decoded.data());
+			glTexImage2D(GL_TEXTURE_2D, i, GL_RGBA, level.width, level.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, decoded.data());
+			gpuBytes += decoded.size();
+		}
+	}
+
+	mipLevels = levels;
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levels - 1);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, levels > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+	return true;
+}
+
 bool Texture::Bind()
 {
-	glBindTexture(GL_TEXTURE_2D, id);
+	StateCache::BindTexture(id);
 	return false;
 }
 
@@ -12,6 +12,9 @@
 #include <Glad/glad.h>
 #include <iostream>
 
+#include <AvgEngine/Render/BlockCompression.h>
+#include <AvgEngine/Render/Mipmaps.h>
+
 namespace AvgEngine::OpenGL
 {
 	struct texData
@@ -41,11 +44,46 @@ namespace AvgEngine::OpenGL
 				unsigned char c[] = { 255, 255, 255, 255 };
 				t = new AvgEngine::OpenGL::Texture(reinterpret_cast<unsigned char*>(c), 1, 1);
 				t->dontDelete = true;
+				t->pixels = NULL;
 			}
 			return t;
 		}
 
-		static AvgEngine::OpenGL::Texture* createWithImage(std::string filePath);
+		/**
+		 * \brief If textures loaded from files keep their pixels on the CPU after they're uploaded (off by default, Pixels reads them back when they're needed)
+		 */
+		static inline bool keepPixels = false;
+
+		/**
+		 * \brief How new textures make their mips (None by default, so nothing changes unless asked for)
+		 */
+		static inline Render::MipMode defaultMipMode = Render::MipMode::None;
+
+		/**
+		 * \brief Loads a texture from an image file
+		 * \param filePath The file path
+		 * \param keep If the texture should hold on to its pixels after uploading them
+		 * \param mips How to make its mips
+		 * \return The loaded texture (or the white texture if it failed)
+		 */
+		static AvgEngine::OpenGL::Texture* createWithImage(std::string filePath, bool keep = keepPixels, Render::MipMode mips = defaultMipMode);
+
+		/**
+		 * \brief Decode compressed textures on the CPU even if the GPU can sample them (for testing the fallback)
+		 */
+		static inline bool decodeCompressed = false;
+
+		/**
+		 * \brief If the GPU can sample a block compressed format (Extensions has to be loaded)
+		 */
+		static bool SupportsFormat(Render::BlockFormat format);
+
+		/**
+		 * \brief Loads a block compressed texture from a .dds or .ktx2 file (createWithImage does this for those too)
+		 * \param filePath The file path
+		 * \return The loaded texture (or the white texture if it failed)
+		 */
+		static AvgEngine::OpenGL::Texture* createWithCompressed(std::string filePath);
 
 		static AvgEngine::OpenGL::Texture* loadTextureFromData(char* data, size_t outLength);
 		static AvgEngine::OpenGL::Texture* loadTextureFromData(unsigned char* data, int w, int h);
@@ -56,16 +94,73 @@ namespace AvgEngine::OpenGL
 
 		int width{};
 		int height{};
+		/**
+		 * \brief If pixels belongs to this texture (and gets freed with it). Only Pixels() and the stb loads set it, SetData clears it
+		 */
 		bool fromSTBI = false;
+		/**
+		 * \brief The texture's pixels on the CPU, which are usually NULL after upload (use Pixels to get them)
+		 */
 		unsigned char* pixels{};
 
+		/**
+		 * \brief The format the texture is stored in on the GPU (None if it's plain RGBA)
+		 */
+		Render::BlockFormat compressedFormat = Render::BlockFormat::None;
+		/**
+		 * \brief How much memory the texture takes up on the GPU (every level)
+		 */
+		size_t gpuBytes = 0;
+		/**
+		 * \brief How this texture's mips were made. Set it before SetData to pick how the next upload makes them, or use BuildMips.
+		 */
+		Render::MipMode mipMode = defaultMipMode;
+		/**
+		 * \brief How many levels are on the GPU (1 without mips)
+		 */
+		int mipLevels = 1;
+
+		/**
+		 * \brief Gets the texture's pixels, reading them back from the GPU if they weren't kept. Has to be called on the GL thread.
+		 * Read back pixels stay until ReleasePixels, and aren't updated by SetSubData.
+		 * \return The RGBA pixels (width * height * 4), or NULL if they couldn't be read
+		 */
+		unsigned char* Pixels();
+
+		/**
+		 * \brief Drops the CPU copy of the pixels (freeing it if it's ours), the texture on the GPU is untouched
+		 */
+		void ReleasePixels();
+
 		Texture(unsigned char* data, const unsigned int width, const unsigned int height);
 		Texture(unsigned char* data, const int width, const int height);
 		Texture(unsigned char* data, const unsigned int width, const unsigned int height, bool mssa);
 		~Texture();
 
 		//Texture interface
+		/**
+		 * \brief Uploads new pixels. A buffer the texture owned is freed, data stays the caller's
+		 */
 		bool SetData(unsigned char* data, const unsigned int width, const unsigned int height);
+		/**
+		 * \brief Updates part of the texture. Mips aren't updated, call BuildMips after if they're needed.
+		 */
+		bool SetSubData(unsigned char* data, int x, int y, int w, int h);
+		/**
+		 * \brief (Re)builds the mip chain from the current pixels (Box and Kaiser read them back if they weren't kept). Block compressed textures keep the mips they were loaded with.
+		 * \param mode How to make them (None drops them)
+		 */
+		void BuildMips(Render::MipMode mode);
+		/**
+		 * \brief Uploads mips that were already made (like on TextureLoader's workers), and switches to mipmapped sampling
+		 * \param levels Levels 1 and down
+		 * \param mode How they were made
+		 */
+		void SetMips(const std::vector<Render::MipLevel>& levels, Render::MipMode mode);
+		/**
+		 * \brief Uploads a block compressed image and its mips, decoding it first if the GPU can't sample the format
+		 */
+		bool SetCompressedData(const Render::CompressedImage& image);
 		bool Bind();
 		bool Unbind();
 	};
@@ -0,0 +1,175 @@
+/*
+	Copyright 2021-2023 AvgEngine - Kade
+
+	Use of this source code without explict permission from owner is strictly prohibited.
+*/
+
+#include <AvgEngine/Render/QuadBatch.h>
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define QUADBATCH_SSE2
+#include <emmintrin.h>
+#endif
+
+using namespace AvgEngine::Render;
+
+#ifndef QUADBATCH_CPP
+#define QUADBATCH_CPP
+
+void QuadBatch::ExpandScalar(std::span<Vertex> out, size_t first, size_t count) const
+{
+	size_t end = first + std::min(count, size() - first);
+	for (size_t i = first; i < end; i++)
+	{
+		float rx = x[i], ry = y[i], rw = w[i], rh = h[i];
+		if (center[i] != 0)
+		{
+			rx += (rw * (1 - scale[i])) / 2;
+			ry += (rh * (1 - scale[i])) / 2;
+		}
+		rw *= scale[i];
+		rh *= scale[i];
+
+		uint32_t colour = Vertex::PackColour(r[i] / 255, g[i] / 255, b[i] / 255, a[i]);
+
+		Vertex* v = &out[(i - first) * 4];
+		v[0] = Vertex(rx, ry, srcX[i], srcY[i], colour);
+		v[1] = Vertex(rx, ry + rh, srcX[i], srcY[i] + srcH[i], colour);
+		v[2] = Vertex(rx + rw, ry, srcX[i] + srcW[i], srcY[i], colour);
+		v[3] = Vertex(rx + rw, ry + rh, srcX[i] + srcW[i], srcY[i] + srcH[i], colour);
+
+		if (angle[i] != 0)
+		{
+			// once per quad, in float
+			float rad = angle[i] * (3.14159265f / 180);
+			float s = std::sin(rad);
+			float c = std::cos(rad);
+			float cx = rx + rw * 0.5f;
+			float cy = ry + rh * 0.5f;
+			for (int j = 0; j < 4; j++)
+			{
+				float tx = v[j].x - cx;
+				float ty = v[j].y - cy;
+				v[j].x = (tx * c - ty * s) + cx;
+				v[j].y = (tx * s + ty * c) + cy;
+			}
+		}
+	}
+}
+
+#ifdef QUADBATCH_SSE2
+
+void QuadBatch::Expand(std::span<Vertex> out, size_t first, size_t count) const
+{
+	count = std::min(count, size() - first);
+	const size_t simdEnd = first + count - (count % 4);
+
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 one = _mm_set1_ps(1);
+	const __m128 half = _mm_set1_ps(0.5f);
+	const __m128 max = _mm_set1_ps(255);
+
+	auto channel = [&](__m128 c) {
+		c = _mm_min_ps(_mm_max_ps(c, zero), one);
+		return _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(c, max), half));
+	};
+
+	alignas(16) float px[4][4], py[4][4], pu[4][4], pv[4][4];
+	alignas(16) uint32_t colours[4];
+
+	for (size_t i = first; i < simdEnd; i += 4)
+	{
+		__m128 rx = _mm_loadu_ps(&x[i]);
+		__m128 ry = _mm_loadu_ps(&y[i]);
+		__m128 rw = _mm_loadu_ps(&w[i]);
+		__m128 rh = _mm_loadu_ps(&h[i]);
+		__m128 sc = _mm_loadu_ps(&scale[i]);
+
+		// center: x += (w * (1 - scale)) / 2, only for the quads that have it set
+		__m128 centered = _mm_cmpneq_ps(_mm_loadu_ps(&center[i]), zero);
+		__m128 shrink = _mm_sub_ps(one, sc);
+		rx = _mm_add_ps(rx, _mm_and_ps(centered, _mm_div_ps(_mm_mul_ps(rw, shrink), _mm_set1_ps(2))));
+		ry = _mm_add_ps(ry, _mm_and_ps(centered, _mm_div_ps(_mm_mul_ps(rh, shrink), _mm_set1_ps(2))));
+		rw = _mm_mul_ps(rw, sc);
+		rh = _mm_mul_ps(rh, sc);
+
+		__m128i col = channel(_mm_div_ps(_mm_loadu_ps(&r[i]), max));
+		col = _mm_or_si128(col, _mm_slli_epi32(channel(_mm_div_ps(_mm_loadu_ps(&g[i]), max)), 8));
+		col = _mm_or_si128(col, _mm_slli_epi32(channel(_mm_div_ps(_mm_loadu_ps(&b[i]), max)), 16));
+		col = _mm_or_si128(col, _mm_slli_epi32(channel(_mm_loadu_ps(&a[i])), 24));
+		_mm_store_si128(reinterpret_cast<__m128i*>(colours), col);
+
+		__m128 right = _mm_add_ps(rx, rw);
+		__m128 bottom = _mm_add_ps(ry, rh);
+
+		// tl, bl, tr, br
+		__m128 cornerX[4] = { rx, rx, right, right };
+		__m128 cornerY[4] = { ry, bottom, ry, bottom };
+
+		__m128 sx = _mm_loadu_ps(&srcX[i]);
+		__m128 sy = _mm_loadu_ps(&srcY[i]);
+		__m128 sRight = _mm_add_ps(sx, _mm_loadu_ps(&srcW[i]));
+		__m128 sBottom = _mm_add_ps(sy, _mm_loadu_ps(&srcH[i]));
+		__m128 cornerU[4] = { sx, sx, sRight, sRight };
+		__m128 cornerV[4] = { sy, sBottom, sy, sBottom };
+
+		__m128 ang = _mm_loadu_ps(&angle[i]);
+		__m128 rotated = _mm_cmpneq_ps(ang, zero);
+		if (_mm_movemask_ps(rotated) != 0)
+		{
+			// no sin/cos in SSE, so do it per quad (in float) and rotate all 4 at once
+			alignas(16) float angles[4], sines[4], cosines[4];
+			_mm_store_ps(angles, ang);
+			for (int j = 0; j < 4; j++)
+			{
+				float rad = angles[j] * (3.14159265f / 180);
+				sines[j] = std::sin(rad);
+				cosines[j] = std::cos(rad);
+			}
+			__m128 s = _mm_load_ps(sines);
+			__m128 c = _mm_load_ps(cosines);
+			__m128 cx = _mm_add_ps(rx, _mm_mul_ps(rw, half));
+			__m128 cy = _mm_add_ps(ry, _mm_mul_ps(rh, half));
+
+			for (int j = 0; j < 4; j++)
+			{
+				__m128 tx = _mm_sub_ps(cornerX[j], cx);
+				__m128 ty = _mm_sub_ps(cornerY[j], cy);
+				__m128 nx = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(tx, c), _mm_mul_ps(ty, s)), cx);
+				__m128 ny = _mm_add_ps(_mm_add_ps(_mm_mul_ps(tx, s), _mm_mul_ps(ty, c)), cy);
+				// quads without an angle keep their exact corners
+				cornerX[j] = _mm_or_ps(_mm_and_ps(rotated, nx), _mm_andnot_ps(rotated, cornerX[j]));
+				cornerY[j] = _mm_or_ps(_mm_and_ps(rotated, ny), _mm_andnot_ps(rotated, cornerY[j]));
+			}
+		}
+
+		for (int j = 0; j < 4; j++)
+		{
+			_mm_store_ps(px[j], cornerX[j]);
+			_mm_store_ps(py[j], cornerY[j]);
+			_mm_store_ps(pu[j], cornerU[j]);
+			_mm_store_ps(pv[j], cornerV[j]);
+		}
+
+		Vertex* v = &out[(i - first) * 4];
+		for (int q = 0; q < 4; q++)
+			for (int j = 0; j < 4; j++)
+				v[q * 4 + j] = Vertex(px[j][q], py[j][q], pu[j][q], pv[j][q], colours[q]);
+	}
+
+	ExpandScalar(out.subspan((simdEnd - first) * 4), simdEnd, first + count - simdEnd);
+}
+
+#else
+
+void QuadBatch::Expand(std::span<Vertex> out, size_t first, size_t count) const
+{
+	ExpandScalar(out, first, count);
+}
+
+#endif
+
+#endif // !QUADBATCH_CPP
@@ -0,0 +1,103 @@
+/*
+	Copyright 2021-2023 AvgEngine - Kade
+
+	Use of this source code without explict permission from owner is strictly prohibited.
+*/
+
+#ifndef QUADBATCH_H
+#define QUADBATCH_H
+
+#pragma once
+
+#include <AvgEngine/Render/Display.h>
+
+#include <vector>
+#include <array>
+#include <span>
+#include <cstdint>
+
+namespace AvgEngine::Render
+{
+	/**
+	 * \brief A batch of quads stored as arrays (one per field) so they can be expanded to vertices several at a time.
+	 * Expanding a batch gives the same vertices as calling DisplayHelper::RectToQuad on every quad (within float tolerance when rotated).
+	 */
+	class QuadBatch
+	{
+	public:
+		std::vector<float> x, y, w, h;
+		std::vector<float> scale, angle;
+		std::vector<float> r, g, b, a;
+		std::vector<float> srcX, srcY, srcW, srcH;
+		std::vector<float> center;
+
+		size_t size() const
+		{
+			return x.size();
+		}
+
+		/**
+		 * \brief Empties the batch (keeping its storage)
+		 */
+		void clear()
+		{
+			for (std::vector<float>* v : fields())
+				v->clear();
+		}
+
+		void reserve(size_t count)
+		{
+			for (std::vector<float>* v : fields())
+				v->reserve(count);
+		}
+
+		/**
+		 * \brief Adds a quad to the batch
+		 * \param dst The destination struct
+		 * \param src The source struct
+		 * \param _center If the quad should scale around its center
+		 */
+		void push(const Rect& dst, const Rect& src, bool _center = false)
+		{
+			x.push_back(dst.x);
+			y.push_back(dst.y);
+			w.push_back(dst.w);
+			h.push_back(dst.h);
+			scale.push_back(dst.scale);
+			angle.push_back(dst.angle);
+			r.push_back(dst.r);
+			g.push_back(dst.g);
+			b.push_back(dst.b);
+			a.push_back(dst.a);
+			srcX.push_back(src.x);
+			srcY.push_back(src.y);
+			srcW.push_back(src.w);
+			srcH.push_back(src.h);
+			center.push_back(_center ? 1.0f : 0.0f);
+		}
+
+		/**
+		 * \brief Writes quads in the batch as 4 vertices each (tl, bl, tr, br), using SSE2 when it's available
+		 * \param out Where to write the vertices (should hold count * 4, the first quad goes at the start)
+		 * \param first The first quad to expand
+		 * \param count How many quads to expand (by default, all of them from first on)
+		 */
+		void Expand(std::span<Vertex> out, size_t first = 0, size_t count = SIZE_MAX) const;
+
+		/**
+		 * \brief The scalar version of Expand, used for whatever doesn't fit in the SIMD loop
+		 * \param out Where to write the vertices (should hold count * 4, the first quad goes at the start)
+		 * \param first The first quad to expand
+		 * \param count How many quads to expand (by default, all of them from first on)
+		 */
+		void ExpandScalar(std::span<Vertex> out, size_t first = 0, size_t count = SIZE_MAX) const;
+
+	private:
+		std::array<std::vector<float>*, 15> fields()
+		{
+			return { &x, &y, &w, &h, &scale, &angle, &r, &g, &b, &a, &srcX, &srcY, &srcW, &srcH, &center };
+		}
+	};
+}
+
+#endif // !QUADBATCH_H
@@ -0,0 +1,237 @@
+/*
+	Copyright 2021-2023 AvgEngine - Kade
+
+	Use of this source code without explict permission from owner is strictly prohibited.
+*/
+
+#include <AvgEngine/Render/TextureAtlas.h>
+#include <AvgEngine/External/Image/stbi.h>
+#include <AvgEngine/Utils/Logging.h>
+
+#include <climits>
+
+using namespace AvgEngine::Render;
+
+#ifndef TEXTUREATLAS_CPP
+#define TEXTUREATLAS_CPP
+
+bool AtlasPage::Pack(int w, int h, int* outX, int* outY)
+{
+	int bestY = INT_MAX;
+	int bestX = 0;
+	int bestNode = -1;
+	int bestWidth = INT_MAX;
+
+	// find the lowest spot (then the narrowest node) the rectangle can sit on
+	for (size_t i = 0; i < skyline.size(); i++)
+	{
+		int x = skyline[i].x;
+		if (x + w > size)
+			break;
+
+		int y = 0;
+		int widthLeft = w;
+		size_t j = i;
+		while (widthLeft > 0 && j < skyline.size())
+		{
+			if (skyline[j].y > y)
+				y = skyline[j].y;
+			widthLeft -= skyline[j].w;
+			j++;
+		}
+
+		if (y + h > size)
+			continue;
+
+		if (y < bestY || (y == bestY && skyline[i].w < bestWidth))
+		{
+			bestY = y;
+			bestX = x;
+			bestNode = static_cast<int>(i);
+			bestWidth = skyline[i].w;
+		}
+	}
+
+	if (bestNode == -1)
+		return false;
+
+	// raise the skyline under the new rectangle
+	SkylineNode node;
+	node.x = bestX;
+	node.y = bestY + h;
+	node.w = w;
+	skyline.insert(skyline.begin() + bestNode, node);
+
+	for (size_t i = bestNode + 1; i < skyline.size(); i++)
+	{
+		SkylineNode& prev = skyline[i - 1];
+		SkylineNode& cur = skyline[i];
+		if (cur.x >= prev.x + prev.w)
+			break;
+
+		int shrink = prev.x + prev.w - cur.x;
+		cur.x += shrink;
+		cur.w -= shrink;
+		if (cur.w > 0)
+			break;
+
+		skyline.erase(skyline.begin() + i);
+		i--;
+	}
+
+	// merge neighbours at the same height
+	for (size_t i = 0; i + 1 < skyline.size(); i++)
+	{
+		if (skyline[i].y == skyline[i + 1].y)
+		{
+			skyline[i].w += skyline[i + 1].w;
+			skyline.erase(skyline.begin() + i + 1);
+			i--;
+		}
+	}
+
+	usedPixels += static_cast<size_t>(w) * h;
+	*outX = bestX;
+	*outY = bestY;
+	return true;
+}
+
+TextureAtlas::~TextureAtlas()
+{
+	Clear();
+}
+
+AtlasPage& TextureAtlas::NewPage()
+{
+	AtlasPage page;
+	page.size = pageSize;
+	// start out transparent, so the padding around images is actually empty
+	std::vector<unsigned char> clear(static_cast<size_t>(pageSize) * pageSize * 4, 0);
+	page.texture = new OpenGL::Texture(clear.data(), pageSize, pageSize);
+	page.texture->pixels = NULL;
+	page.texture->dontDelete = true;
+
+	AtlasPage::SkylineNode node;
+	node.w = pageSize;
+	page.skyline.push_back(node);
+
+	pages.push_back(page);
+#ifdef _DEBUG
+	Logging::writeLog("[Atlas] [Debug] Created page " + std::to_string(pages.size()) + " (" + std::to_string(pageSize) + "x" + std::to_string(pageSize) + ")");
+#endif
+	return pages.back();
+}
+
+AtlasRegion TextureAtlas::Add(std::string filePath)
+{
+	auto it = regions.find(filePath);
+	if (it != regions.end())
+		return it->second;
+
+	int w = 0;
+	int h = 0;
+	unsigned char* data = External::stbi_h::stbi_load_file_data(filePath, &w, &h);
+	if (data == NULL || w == 0 || h == 0)
+	{
+		Logging::writeLog("[Atlas] [Error] Failed to load " + filePath);
+		AtlasRegion region;
+		region.texture = OpenGL::Texture::returnWhiteTexture();
+		region.width = 1;
+		region.height = 1;
+		return region;
+	}
+
+	AtlasRegion region = Add(filePath, data, w, h);
+
+	// the atlas has its own copy on the GPU now (unless it got its own texture, which takes the data)
+	if (region.packed)
+		External::stbi_h::stbi_free(data);
+	else
+	{
+		region.texture->fromSTBI = true;
+		if (!OpenGL::Texture::keepPixels)
+			region.texture->ReleasePixels();
+	}
+
+	return region;
+}
+
+AtlasRegion TextureAtlas::Add(std::string key, unsigned char* data, int w, int h)
+{
+	auto it = regions.find(key);
+	if (it != regions.end())
+		return it->second;
+
+	AtlasRegion region;
+	region.width = w;
+	region.height = h;
+
+	int paddedW = w + padding * 2;
+	int paddedH = h + padding * 2;
+
+	if (paddedW > pageSize || paddedH > pageSize)
+	{
+		// too big to share a page, it gets its own texture
+		region.texture = new OpenGL::Texture(data, w, h);
+		region.packed = false;
+		regions[key] = region;
+		return region;
+	}
+
+	int x = 0;
+	int y = 0;
+	AtlasPage* page = NULL;
+	for (AtlasPage& p : pages)
+	{
+		if (p.Pack(paddedW, paddedH, &x, &y))
+		{
+			page = &p;
+			break;
+		}
+	}
+
+	if (page == NULL)
+	{
+		page = &NewPage();
+		page->Pack(paddedW, paddedH, &x, &y);
+	}
+
+	x += padding;
+	y += padding;
+	page->texture->SetSubData(data, x, y, w, h);
+
+	region.texture = page->texture;
+	region.packed = true;
+	region.src = { static_cast<float>(x) / pageSize, static_cast<float>(y) / pageSize, static_cast<float>(w) / pageSize, static_cast<float>(h) / pageSize };
+	regions[key] = region;
+	return region;
+}
+
+void TextureAtlas::Clear()
+{
+	for (auto& [key, region] : regions)
+		if (!region.packed)
+			delete region.texture;
+	for (AtlasPage& page : pages)
+		delete page.texture;
+	regions.clear();
+	pages.clear();
+}
+
+AtlasStats TextureAtlas::GetStats()
+{
+	AtlasStats stats;
+	stats.pages = static_cast<int>(pages.size());
+	stats.images = static_cast<int>(regions.size());
+	for (auto& [key, region] : regions)
+		if (region.packed)
+			stats.packedImages++;
+	for (AtlasPage& page : pages)
+	{
+		stats.usedPixels += page.usedPixels;
+		stats.totalPixels += static_cast<size_t>(page.size) * page.size;
+	}
+	return stats;
+}
+
+#endif // !TEXTUREATLAS_CPP
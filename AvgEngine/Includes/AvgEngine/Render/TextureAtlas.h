@@ -0,0 +1,154 @@
+/*
+	Copyright 2021-2023 AvgEngine - Kade
+
+	Use of this source code without explict permission from owner is strictly prohibited.
+*/
+
+#ifndef TEXTUREATLAS_H
+#define TEXTUREATLAS_H
+
+#pragma once
+
+#include <AvgEngine/Render/Display.h>
+#include <AvgEngine/Render/OpenGL/Texture.h>
+
+#include <unordered_map>
+#include <vector>
+#include <string>
+
+namespace AvgEngine::Render
+{
+	/**
+	 * \brief A packed image. src is normalized, so it can be used as a Sprite's src directly.
+	 */
+	struct AtlasRegion
+	{
+		OpenGL::Texture* texture = NULL;
+		Rect src = { 0,0,1,1 };
+		int width = 0;
+		int height = 0;
+		/**
+		 * \brief If the image was packed into a page (false if it was too big and got its own texture)
+		 */
+		bool packed = false;
+	};
+
+	struct AtlasStats
+	{
+		int pages = 0;
+		int images = 0;
+		int packedImages = 0;
+		size_t usedPixels = 0;
+		size_t totalPixels = 0;
+
+		/**
+		 * \brief How much of the pages are taken up by images (0-1)
+		 */
+		float occupancy() const
+		{
+			return totalPixels == 0 ? 0 : static_cast<float>(usedPixels) / static_cast<float>(totalPixels);
+		}
+
+		/**
+		 * \brief How many texture switches (and so draw calls) packing saves at most, compared to every image having its own texture
+		 */
+		int batchReduction() const
+		{
+			return packedImages - pages;
+		}
+	};
+
+	/**
+	 * \brief One texture of an atlas, packed with a skyline (bottom-left) packer
+	 */
+	struct AtlasPage
+	{
+		struct SkylineNode
+		{
+			int x = 0, y = 0, w = 0;
+		};
+
+		OpenGL::Texture* texture = NULL;
+		std::vector<SkylineNode> skyline;
+		size_t usedPixels = 0;
+		int size = 0;
+
+		/**
+		 * \brief Finds a spot for a rectangle and reserves it
+		 * \param w The width of the rectangle
+		 * \param h The height of the rectangle
+		 * \param outX A reference to a variable to output the x coordinate to
+		 * \param outY A reference to a variable to output the y coordinate to
+		 * \return If the rectangle fit
+		 */
+		bool Pack(int w, int h, int* outX, int* outY);
+	};
+
+	/**
+	 * \brief Packs images into a few large textures so sprites that share a page can be batched together
+	 */
+	class TextureAtlas
+	{
+	public:
+		/**
+		 * \brief The width and height of each page
+		 */
+		int pageSize = 2048;
+		/**
+		 * \brief Empty pixels between images, so linear filtering doesn't bleed into neighbours
+		 */
+		int padding = 1;
+
+		std::vector<AtlasPage> pages;
+		std::unordered_map<std::string, AtlasRegion> regions;
+
+		TextureAtlas() = default;
+		TextureAtlas(int _pageSize, int _padding = 1)
+		{
+			pageSize = _pageSize;
+			padding = _padding;
+		}
+
+		~TextureAtlas();
+
+		/**
+		 * \brief The atlas Sprites use by default
+		 */
+		static TextureAtlas* GetDefault()
+		{
+			static TextureAtlas* atlas = NULL;
+			if (atlas == NULL)
+				atlas = new TextureAtlas();
+			return atlas;
+		}
+
+		/**
+		 * \brief Loads an image and packs it (or returns the region it was already packed to)
+		 * \param filePath The file path
+		 * \return The region the image is in
+		 */
+		AtlasRegion Add(std::string filePath);
+
+		/**
+		 * \brief Packs RGBA pixel data
+		 * \param key The name to store the region under
+		 * \param data The RGBA data
+		 * \param w The width of the data
+		 * \param h The height of the data
+		 * \return The region the image is in
+		 */
+		AtlasRegion Add(std::string key, unsigned char* data, int w, int h);
+
+		/**
+		 * \brief Deletes every page and forgets every region (sprites still using them will draw garbage)
+		 */
+		void Clear();
+
+		AtlasStats GetStats();
+
+	private:
+		AtlasPage& NewPage();
+	};
+}
+
+#endif // !TEXTUREATLAS_H
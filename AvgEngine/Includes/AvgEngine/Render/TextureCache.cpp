@@ -0,0 +1,275 @@
+/*
+	Copyright 2021-2023 AvgEngine - Kade
+
+	Use of this source code without explict permission from owner is strictly prohibited.
+*/
+
+#include <AvgEngine/Render/TextureCache.h>
+#include <AvgEngine/Utils/Logging.h>
+
+#include <algorithm>
+#include <filesystem>
+
+using namespace AvgEngine::Render;
+
+#ifndef TEXTURECACHE_CPP
+#define TEXTURECACHE_CPP
+
+TextureCache* TextureCache::instance = NULL;
+
+TextureCache::~TextureCache()
+{
+	Clear();
+	if (instance == this)
+		instance = NULL;
+}
+
+std::string TextureCache::Key(const std::string& filePath)
+{
+	std::error_code error;
+	std::filesystem::path canonical = std::filesystem::weakly_canonical(filePath, error);
+	if (error)
+		return filePath;
+	return canonical.generic_string();
+}
+
+void TextureCache::Measure(Entry& entry)
+{
+	gpuBytes -= entry.gpuBytes;
+	cpuBytes -= entry.cpuBytes;
+	cpuSavedBytes -= entry.cpuSavedBytes;
+
+	size_t bytes = static_cast<size_t>(entry.texture->width) * entry.texture->height * 4;
+	// compressed textures (and ones with mips) aren't just width * height * 4 on the GPU
+	entry.gpuBytes = entry.texture->gpuBytes != 0 ? entry.texture->gpuBytes : bytes;
+	entry.cpuBytes = entry.texture->pixels != NULL && entry.texture->fromSTBI ? bytes : 0;
+	// a texture that's still loading hasn't got anything to save yet
+	entry.cpuSavedBytes = entry.loading ? 0 : bytes - entry.cpuBytes;
+
+	gpuBytes += entry.gpuBytes;
+	cpuBytes += entry.cpuBytes;
+	cpuSavedBytes += entry.cpuSavedBytes;
+}
+
+void TextureCache::WantMips(Entry& entry, MipMode mips)
+{
+	if (mips == MipMode::None)
+		return;
+	// a load in flight gets them when it finishes
+	if (entry.loading)
+	{
+		if (entry.mips == MipMode::None)
+			entry.mips = mips;
+		return;
+	}
+	// only ever added, someone else might be counting on the ones that are there
+	if (entry.texture->mipMode == MipMode::None && entry.texture->compressedFormat == BlockFormat::None)
+	{
+		entry.texture->BuildMips(mips);
+		Measure(entry);
+	}
+}
+
+AvgEngine::OpenGL::Texture* TextureCache::Acquire(std::string filePath, MipMode mips)
+{
+	std::string key = Key(filePath);
+	auto it = entries.find(key);
+	if (it != entries.end())
+	{
+		it->second.refs++;
+		it->second.lastUsed = ++tick;
+		WantMips(it->second, mips);
+		return it->second.texture;
+	}
+
+	OpenGL::Texture* texture = OpenGL::Texture::createWithImage(filePath, OpenGL::Texture::keepPixels, mips);
+	// a missing image gives back the shared white texture, which isn't ours to cache
+	if (texture->dontDelete)
+		return texture;
+
+	Entry& entry = entries[key];
+	entry.texture = texture;
+	entry.refs = 1;
+	entry.lastUsed = ++tick;
+	byTexture[texture] = key;
+	Measure(entry);
+	Trim();
+	return texture;
+}
+
+AvgEngine::OpenGL::Texture* TextureCache::AcquireAsync(std::string filePath, TextureLoader::Callback onLoad, MipMode mips)
+{
+	std::string key = Key(filePath);
+	auto it = entries.find(key);
+	if (it != entries.end())
+	{
+		Entry& entry = it->second;
+		entry.refs++;
+		entry.lastUsed = ++tick;
+		WantMips(entry, mips);
+		if (onLoad && !entry.loading)
+			onLoad(entry.texture, true);
+		else if (onLoad)
+			waiting[entry.texture].push_back(onLoad);
+		return entry.texture;
+	}
+
+	OpenGL::Texture* texture = TextureLoader::GetDefault()->Load(filePath, [this, key](OpenGL::Texture* t, bool ok) {
+		auto it = entries.find(key);
+		if (it != entries.end())
+		{
+			it->second.loading = false;
+			if (ok)
+				WantMips(it->second, it->second.mips);
+			Measure(it->second);
+		}
+
+		auto w = waiting.find(t);
+		if (w != waiting.end())
+		{
+			std::vector<TextureLoader::Callback> callbacks = std::move(w->second);
+			waiting.erase(w);
+			for (TextureLoader::Callback& callback : callbacks)
+				callback(t, ok);
+		}
+
+		Trim();
+	}, NULL, mips);
+
+	Entry& entry = entries[key];
+	entry.texture = texture;
+	entry.refs = 1;
+	entry.lastUsed = ++tick;
+	entry.loading = true;
+	entry.mips = mips;
+	byTexture[texture] = key;
+	if (onLoad)
+		waiting[texture].push_back(onLoad);
+	Measure(entry);
+	return texture;
+}
+
+void TextureCache::Retain(OpenGL::Texture* texture)
+{
+	auto it = byTexture.find(texture);
+	if (it == byTexture.end())
+		return;
+	Entry& entry = entries[it->second];
+	entry.refs++;
+	entry.lastUsed = ++tick;
+}
+
+void TextureCache::Release(OpenGL::Texture* texture)
+{
+	auto it = byTexture.find(texture);
+	if (it == byTexture.end())
+		return;
+	std::string key = it->second;
+	Entry& entry = entries[key];
+	if (entry.refs > 0)
+		entry.refs--;
+	entry.lastUsed = ++tick;
+
+	if (entry.refs != 0)
+		return;
+
+	// nobody wants it anymore, so there's no point finishing the load
+	if (entry.loading)
+	{
+		Evict(key);
+		return;
+	}
+	Trim();
+}
+
+void TextureCache::Evict(const std::string& key)
+{
+	auto it = entries.find(key);
+	if (it == entries.end())
+		return;
+	Entry& entry = it->second;
+
+	if (entry.loading && TextureLoader::instance)
+		TextureLoader::instance->Cancel(entry.texture);
+	waiting.erase(entry.texture);
+
+	gpuBytes -= entry.gpuBytes;
+	cpuBytes -= entry.cpuBytes;
+	cpuSavedBytes -= entry.cpuSavedBytes;
+	byTexture.erase(entry.texture);
+	delete entry.texture;
+	entries.erase(it);
+}
+
+void TextureCache::Trim()
+{
+	if (gpuBytes <= vramBudget && cpuBytes <= ramBudget)
+		return;
+
+	std::vector<std::pair<uint64_t, std::string>> unused;
+	for (auto& [key, entry] : entries)
+		if (entry.refs == 0 && !entry.loading)
+			unused.emplace_back(entry.lastUsed, key);
+	std::sort(unused.begin(), unused.end());
+
+	for (auto& [lastUsed, key] : unused)
+	{
+		if (gpuBytes <= vramBudget && cpuBytes <= ramBudget)
+			break;
+		Evict(key);
+	}
+}
+
+void TextureCache::Clear()
+{
+	std::vector<std::string> unused;
+	for (auto& [key, entry] : entries)
+		if (entry.refs == 0)
+			unused.push_back(key);
+	for (std::string& key : unused)
+		Evict(key);
+}
+
+std::vector<TextureMemory> TextureCache::Report()
+{
+	std::vector<TextureMemory> report;
+	report.reserve(entries.size());
+	for (auto& [key, entry] : entries)
+	{
+		// pixels can be read back or released after the texture was cached
+		Measure(entry);
+
+		TextureMemory m;
+		m.key = key;
+		m.refs = entry.refs;
+		m.width = entry.texture->width;
+		m.height = entry.texture->height;
+		m.gpuBytes = entry.gpuBytes;
+		m.cpuBytes = entry.cpuBytes;
+		m.cpuSavedBytes = entry.cpuSavedBytes;
+		m.loading = entry.loading;
+		report.push_back(m);
+	}
+	std::sort(report.begin(), report.end(), [](const TextureMemory& a, const TextureMemory& b) {
+		return a.gpuBytes + a.cpuBytes > b.gpuBytes + b.cpuBytes;
+	});
+	return report;
+}
+
+void TextureCache::LogReport(std::string label)
+{
+	std::vector<TextureMemory> report = Report();
+	int referenced = 0;
+	for (TextureMemory& m : report)
+		if (m.refs > 0)
+			referenced++;
+
+	Logging::writeLog("[TextureCache] " + label + ": " + std::to_string(report.size()) + " textures (" + std::to_string(referenced) + " in use), " +
+		std::to_string(gpuBytes / 1024) + "KB GPU, " + std::to_string(cpuBytes / 1024) + "KB CPU (" +
+		std::to_string(cpuSavedBytes / 1024) + "KB CPU saved by not keeping pixels)");
+	for (TextureMemory& m : report)
+		Logging::writeLog("[TextureCache]   " + m.key + " " + std::to_string(m.width) + "x" + std::to_string(m.height) +
+			" refs " + std::to_string(m.refs) + ", " + std::to_string(m.gpuBytes / 1024) + "KB GPU, " + std::to_string(m.cpuBytes / 1024) + "KB CPU" + (m.loading ? " (loading)" : ""));
+}
+
+#endif // !TEXTURECACHE_CPP
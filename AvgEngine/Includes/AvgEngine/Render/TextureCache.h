@@ -0,0 +1,192 @@
+/*
+	Copyright 2021-2023 AvgEngine - Kade
+
+	Use of this source code without explict permission from owner is strictly prohibited.
+*/
+
+#ifndef TEXTURECACHE_H
+#define TEXTURECACHE_H
+
+#pragma once
+
+#include <AvgEngine/Render/OpenGL/Texture.h>
+#include <AvgEngine/Render/TextureLoader.h>
+
+#include <unordered_map>
+#include <vector>
+#include <string>
+#include <cstdint>
+
+namespace AvgEngine::Render
+{
+	/**
+	 * \brief How much memory a cached texture is using
+	 */
+	struct TextureMemory
+	{
+		std::string key = "";
+		int refs = 0;
+		int width = 0, height = 0;
+		size_t gpuBytes = 0;
+		/**
+		 * \brief Pixels still held on the CPU (only textures that kept or read back their pixels have any)
+		 */
+		size_t cpuBytes = 0;
+		/**
+		 * \brief CPU memory saved by not keeping the pixels after upload
+		 */
+		size_t cpuSavedBytes = 0;
+		bool loading = false;
+	};
+
+	/**
+	 * \brief Shares textures loaded from the same file. Textures are reference counted, and ones nobody is using are kept around
+	 * (so loading them again is free) until the cache goes over budget, then the least recently used get deleted.
+	 */
+	class TextureCache
+	{
+	public:
+		/**
+		 * \brief The cache Sprites use (NULL until GetDefault is first called)
+		 */
+		static TextureCache* instance;
+
+		static TextureCache* GetDefault()
+		{
+			if (instance == NULL)
+				instance = new TextureCache();
+			return instance;
+		}
+
+		/**
+		 * \brief How much GPU memory unused textures can keep taken up before they're evicted (textures in use are never evicted)
+		 */
+		size_t vramBudget = 512 * 1024 * 1024;
+		/**
+		 * \brief How much CPU memory (kept pixels) unused textures can keep taken up before they're evicted
+		 */
+		size_t ramBudget = 256 * 1024 * 1024;
+
+		~TextureCache();
+
+		/**
+		 * \brief Gets the texture for a file (loading it if it isn't cached), and adds a reference to it
+		 * \param filePath The file path
+		 * \param mips How to make its mips (a cached texture without mips gets them, ones with mips keep theirs)
+		 * \return The texture (call Release when done with it)
+		 */
+		OpenGL::Texture* Acquire(std::string filePath, MipMode mips = OpenGL::Texture::defaultMipMode);
+
+		/**
+		 * \brief Like Acquire, but loads with TextureLoader if it isn't cached. The texture is white until it's loaded, and the load is cancelled if every reference is released first.
+		 * \param filePath The file path
+		 * \param onLoad Called when it's loaded (right away if it's already cached and loaded)
+		 * \param mips How to make its mips (see Acquire)
+		 * \return The texture (call Release when done with it)
+		 */
+		OpenGL::Texture* AcquireAsync(std::string filePath, TextureLoader::Callback onLoad = nullptr, MipMode mips = OpenGL::Texture::defaultMipMode);
+
+		/**
+		 * \brief Adds a reference to a cached texture (does nothing to textures that aren't from the cache)
+		 */
+		void Retain(OpenGL::Texture* texture);
+
+		/**
+		 * \brief Removes a reference from a cached texture (does nothing to textures that aren't from the cache)
+		 */
+		void Release(OpenGL::Texture* texture);
+
+		bool Contains(OpenGL::Texture* texture)
+		{
+			return byTexture.contains(texture);
+		}
+
+		/**
+		 * \brief Evicts unused textures, least recently used first, until the cache is within budget
+		 */
+		void Trim();
+
+		/**
+		 * \brief Deletes every unused texture
+		 */
+		void Clear();
+
+		/**
+		 * \brief Memory use for every cached texture
+		 */
+		std::vector<TextureMemory> Report();
+
+		/**
+		 * \brief Writes the report to the log (textures that are still referenced after a menu switch are usually leaks)
+		 * \param label What to call the report in the log
+		 */
+		void LogReport(std::string label);
+
+		size_t GpuBytes()
+		{
+			return gpuBytes;
+		}
+
+		size_t CpuBytes()
+		{
+			return cpuBytes;
+		}
+
+		/**
+		 * \brief How much CPU memory would be taken up if every loaded texture kept its pixels, minus what is
+		 */
+		size_t CpuBytesSaved()
+		{
+			return cpuSavedBytes;
+		}
+
+	private:
+		struct Entry
+		{
+			OpenGL::Texture* texture = NULL;
+			int refs = 0;
+			uint64_t lastUsed = 0;
+			bool loading = false;
+			/**
+			 * \brief The mips asked for while it was loading
+			 */
+			MipMode mips = MipMode::None;
+			size_t gpuBytes = 0;
+			size_t cpuBytes = 0;
+			size_t cpuSavedBytes = 0;
+		};
+
+		std::unordered_map<std::string, Entry> entries;
+		std::unordered_map<OpenGL::Texture*, std::string> byTexture;
+		/**
+		 * \brief Callbacks for textures that are still loading
+		 */
+		std::unordered_map<OpenGL::Texture*, std::vector<TextureLoader::Callback>> waiting;
+		uint64_t tick = 0;
+		size_t gpuBytes = 0;
+		size_t cpuBytes = 0;
+		size_t cpuSavedBytes = 0;
+
+		/**
+		 * \brief The key a file is cached under (its canonical path, so different spellings of the same file share)
+		 */
+		static std::string Key(const std::string& filePath);
+
+		/**
+		 * \brief Updates an entry's memory use (and the totals) from its texture
+		 */
+		void Measure(Entry& entry);
+
+		/**
+		 * \brief Gives an entry's texture mips if it doesn't have any yet
+		 */
+		void WantMips(Entry& entry, MipMode mips);
+
+		/**
+		 * \brief Deletes an entry's texture and forgets it
+		 */
+		void Evict(const std::string& key);
+	};
+}
+
+#endif // !TEXTURECACHE_H
@@ -0,0 +1,231 @@
+/*
+	Copyright 2021-2023 AvgEngine - Kade
+
+	Use of this source code without explict permission from owner is strictly prohibited.
+*/
+
+#include <AvgEngine/Render/TextureLoader.h>
+#include <AvgEngine/External/Image/stbi.h>
+#include <AvgEngine/Utils/Logging.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+
+using namespace AvgEngine::Render;
+
+#ifndef TEXTURELOADER_CPP
+#define TEXTURELOADER_CPP
+
+TextureLoader* TextureLoader::instance = NULL;
+
+TextureLoader::TextureLoader(int threads)
+{
+	if (threads <= 0)
+		threads = std::clamp(static_cast<int>(std::thread::hardware_concurrency()) - 1, 1, 4);
+	for (int i = 0; i < threads; i++)
+		workers.emplace_back(&TextureLoader::Work, this);
+}
+
+TextureLoader::~TextureLoader()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	jobReady.notify_all();
+	for (std::thread& t : workers)
+		t.join();
+
+	for (Job& job : decoded)
+		if (job.pixels)
+			External::stbi_h::stbi_free(job.pixels);
+	if (instance == this)
+		instance = NULL;
+}
+
+AvgEngine::OpenGL::Texture* TextureLoader::Load(std::string filePath, Callback onLoad, const void* owner, MipMode mips)
+{
+	// its own white texture, so the real image can be put in the same place later
+	unsigned char white[] = { 255, 255, 255, 255 };
+	OpenGL::Texture* texture = new OpenGL::Texture(white, 1, 1);
+	texture->pixels = NULL;
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		Job job;
+		job.id = nextId++;
+		job.path = filePath;
+		job.texture = texture;
+		job.onLoad = onLoad;
+		job.owner = owner;
+		job.mips = mips;
+		jobs.push_back(job);
+	}
+	jobReady.notify_one();
+	return texture;
+}
+
+void TextureLoader::CancelWhere(const std::function<bool(const Job&)>& match)
+{
+	auto drop = [&](std::deque<Job>& queue) {
+		for (auto it = queue.begin(); it != queue.end();)
+		{
+			if (!match(*it))
+			{
+				++it;
+				continue;
+			}
+			if (it->pixels)
+				External::stbi_h::stbi_free(it->pixels);
+			it = queue.erase(it);
+		}
+	};
+	drop(jobs);
+	drop(decoded);
+
+	// the workers throw these out when they're done with them
+	for (const Job& job : decoding)
+		if (match(job))
+			cancelled.insert(job.id);
+}
+
+void TextureLoader::Cancel(OpenGL::Texture* texture)
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		CancelWhere([texture](const Job& job) { return job.texture == texture; });
+	}
+	jobReady.notify_all();
+}
+
+void TextureLoader::CancelOwner(const void* owner)
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		CancelWhere([owner](const Job& job) { return job.owner == owner; });
+	}
+	jobReady.notify_all();
+}
+
+void TextureLoader::Work()
+{
+	while (true)
+	{
+		Job job;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			// wait for a job, and for room to put it once it's decoded
+			jobReady.wait(lock, [this]() {
+				return stopping || (jobs.size() != 0 && decoded.size() + decoding.size() < maxDecoded);
+			});
+			if (stopping)
+				return;
+			job = jobs.front();
+			jobs.pop_front();
+			decoding.push_back(job);
+		}
+
+		if (BlockCompression::IsContainer(job.path))
+			ReadCompressed(job);
+		else
+			job.pixels = External::stbi_h::stbi_load_file_data(job.path, &job.w, &job.h);
+
+		// the GL thread only has to upload them
+		if (job.pixels != NULL && job.w > 0 && job.h > 0)
+			job.mipLevels = Mipmaps::Chain(job.mips, job.pixels, job.w, job.h);
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			decoding.erase(std::find_if(decoding.begin(), decoding.end(), [&job](const Job& j) { return j.id == job.id; }));
+			if (cancelled.erase(job.id) != 0)
+			{
+				if (job.pixels)
+					External::stbi_h::stbi_free(job.pixels);
+			}
+			else
+				decoded.push_back(job);
+		}
+		jobReady.notify_all();
+	}
+}
+
+void TextureLoader::ReadCompressed(Job& job)
+{
+	std::shared_ptr<CompressedImage> image = std::make_shared<CompressedImage>();
+	if (!BlockCompression::Read(job.path, *image, job.error))
+		return;
+
+	if (!OpenGL::Texture::decodeCompressed && OpenGL::Texture::SupportsFormat(image->format))
+	{
+		job.compressed = image;
+		return;
+	}
+
+	// the GPU can't sample it, so decode the top level here instead of on the GL thread (malloc'd like stb_image's, so it's freed the same way)
+	const CompressedLevel& level = image->levels[0];
+	job.pixels = static_cast<unsigned char*>(malloc(static_cast<size_t>(level.width) * level.height * 4));
+	if (job.pixels == NULL)
+		return;
+	BlockCompression::Decode(image->format, level, job.pixels);
+	job.w = level.width;
+	job.h = level.height;
+}
+
+size_t TextureLoader::Update()
+{
+	auto start = std::chrono::steady_clock::now();
+	size_t bytes = 0;
+
+	while (true)
+	{
+		Job job;
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			if (decoded.size() == 0)
+				break;
+			job = decoded.front();
+			decoded.pop_front();
+		}
+		// a slot opened up for the workers
+		jobReady.notify_one();
+
+		bool ok = job.compressed || (job.pixels != NULL && job.w > 0 && job.h > 0);
+		if (job.compressed)
+		{
+			job.texture->SetCompressedData(*job.compressed);
+			bytes += job.texture->gpuBytes;
+		}
+		else if (ok)
+		{
+			bool made = job.mipLevels.size() != 0;
+			job.texture->mipMode = made ? MipMode::None : job.mips;
+			job.texture->SetData(job.pixels, job.w, job.h);
+			if (made)
+				job.texture->SetMips(job.mipLevels, job.mips);
+			job.texture->fromSTBI = true;
+			if (!OpenGL::Texture::keepPixels)
+				job.texture->ReleasePixels();
+			bytes += job.texture->gpuBytes;
+		}
+		else
+			Logging::writeLog("[TextureLoader] [Error] Failed to load " + job.path + (job.error.size() != 0 ? ", " + job.error : ""));
+
+		if (job.onLoad)
+			job.onLoad(job.texture, ok);
+
+		float elapsed = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+		if (bytes >= uploadBudgetBytes || elapsed >= uploadBudgetMs)
+			break;
+	}
+
+	return Pending();
+}
+
+size_t TextureLoader::Pending()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return jobs.size() + decoding.size() + decoded.size();
+}
+
+#endif // !TEXTURELOADER_CPP
@@ -0,0 +1,154 @@
+/*
+	Copyright 2021-2023 AvgEngine - Kade
+
+	Use of this source code without explict permission from owner is strictly prohibited.
+*/
+
+#ifndef TEXTURELOADER_H
+#define TEXTURELOADER_H
+
+#pragma once
+
+#include <AvgEngine/Render/OpenGL/Texture.h>
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <deque>
+#include <vector>
+#include <string>
+#include <unordered_set>
+#include <cstdint>
+#include <memory>
+
+namespace AvgEngine::Render
+{
+	/**
+	 * \brief Loads textures in the background. Images are decoded on a pool of worker threads, and uploaded on the GL thread a few at a time (see Update). .dds and .ktx2 files are uploaded block compressed.
+	 */
+	class TextureLoader
+	{
+	public:
+		/**
+		 * \brief Called on the GL thread when a texture finishes (ok is false if the image couldn't be loaded, the texture stays white)
+		 */
+		typedef std::function<void(OpenGL::Texture* texture, bool ok)> Callback;
+
+		/**
+		 * \brief The loader Game updates every frame (NULL until GetDefault is first called)
+		 */
+		static TextureLoader* instance;
+
+		static TextureLoader* GetDefault()
+		{
+			if (instance == NULL)
+				instance = new TextureLoader();
+			return instance;
+		}
+
+		/**
+		 * \brief How many bytes of pixels can be uploaded in one Update (at least one texture always is)
+		 */
+		size_t uploadBudgetBytes = 16 * 1024 * 1024;
+		/**
+		 * \brief How many milliseconds one Update can spend uploading (at least one texture always is)
+		 */
+		float uploadBudgetMs = 2;
+		/**
+		 * \brief How many decoded images can be waiting for upload (or being decoded) at once, so decoding can't run away with memory
+		 */
+		size_t maxDecoded = 8;
+
+		/**
+		 * \brief Starts the worker threads
+		 * \param threads The amount of decode threads (0 picks based on the CPU, up to 4)
+		 */
+		TextureLoader(int threads = 0);
+		~TextureLoader();
+
+		/**
+		 * \brief Starts loading an image. The texture returned is white until the image is uploaded, then its data gets replaced in place (same pointer, same GL id).
+		 * Don't delete the texture while it's loading without cancelling it first.
+		 * \param filePath The file path
+		 * \param onLoad Called when it's done (not called if it's cancelled)
+		 * \param owner Anything to group loads by, so they can be cancelled together (like the menu that asked for them)
+		 * \param mips How to make its mips (Box and Kaiser are made on the worker threads)
+		 * \return The texture
+		 */
+		OpenGL::Texture* Load(std::string filePath, Callback onLoad = nullptr, const void* owner = NULL, MipMode mips = OpenGL::Texture::defaultMipMode);
+
+		/**
+		 * \brief Stops a texture from loading (it stays white)
+		 */
+		void Cancel(OpenGL::Texture* texture);
+
+		/**
+		 * \brief Stops every load with the given owner
+		 */
+		void CancelOwner(const void* owner);
+
+		/**
+		 * \brief Uploads decoded images (within the budget) and runs their callbacks. Has to be called on the GL thread.
+		 * \return How many loads are still waiting
+		 */
+		size_t Update();
+
+		/**
+		 * \brief How many loads are queued, decoding, or waiting for upload
+		 */
+		size_t Pending();
+
+	private:
+		struct Job
+		{
+			uint64_t id = 0;
+			std::string path = "";
+			OpenGL::Texture* texture = NULL;
+			Callback onLoad = nullptr;
+			const void* owner = NULL;
+			unsigned char* pixels = NULL;
+			int w = 0, h = 0;
+			/**
+			 * \brief The image, if it was a block compressed file the GPU can sample
+			 */
+			std::shared_ptr<CompressedImage> compressed;
+			std::string error = "";
+			MipMode mips = MipMode::None;
+			/**
+			 * \brief The mips made on the worker (levels 1 and down)
+			 */
+			std::vector<MipLevel> mipLevels;
+		};
+
+		std::mutex mutex;
+		std::condition_variable jobReady;
+		std::deque<Job> jobs;
+		std::deque<Job> decoded;
+		/**
+		 * \brief Jobs the workers are decoding right now
+		 */
+		std::vector<Job> decoding;
+		/**
+		 * \brief Ids of jobs that were cancelled while they were being decoded
+		 */
+		std::unordered_set<uint64_t> cancelled;
+		std::vector<std::thread> workers;
+		uint64_t nextId = 0;
+		bool stopping = false;
+
+		void Work();
+
+		/**
+		 * \brief Reads a .dds/.ktx2 for a job, decoding it to pixels if the GPU can't sample its format
+		 */
+		static void ReadCompressed(Job& job);
+
+		/**
+		 * \brief Drops every job that matches (the mutex should be locked)
+		 */
+		void CancelWhere(const std::function<bool(const Job&)>& match);
+	};
+}
+
+#endif // !TEXTURELOADER_H
@@ -0,0 +1,302 @@
+/*
+	Copyright 2021-2023 AvgEngine - Kade
+
+	Use of this source code without explict permission from owner is strictly prohibited.
+*/
+
+/*
+	Compares finding glyphs and kernings through Fnt's lookup tables against the linear scans Fnt used to do.
+
+	GlyphLookupBenchmark [characters] [iterations] [font folder] [font file]
+
+	A paragraph of words (10000 characters by default) is laid out the way Text::Layout walks it (look up each character, take
+	its kerning with the next one, advance, and wrap at 1600 pixels), once with the old lookups (a find_if over chars that
+	copies the FntChar, then a scan of its kernings) and once with FindChar/GetChar and GetKerning. Each reports how long a
+	layout took. The tool fails if the two don't give every glyph the same advance and position.
+
+	Without a font, a made up one with 95 glyphs (ASCII 32-126) and 3000 kerning pairs is used. A .fnt can be given instead,
+	only its data is read (no window or texture is needed).
+*/
+
+#include <AvgEngine/External/SpriteFont/FntParser.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace AvgEngine;
+
+namespace
+{
+	const float wrapWidth = 1600;
+
+	double Now()
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	uint32_t seed = 1234567;
+
+	uint32_t Next(uint32_t range)
+	{
+		seed = seed * 1664525 + 1013904223;
+		return (seed >> 8) % range;
+	}
+
+	/**
+	 * \brief Words of 1 to 10 letters (and some punctuation) until the paragraph is characters long
+	 */
+	std::string MakeParagraph(size_t characters)
+	{
+		std::string paragraph;
+		paragraph.reserve(characters);
+		while (paragraph.size() < characters)
+		{
+			if (paragraph.size() != 0)
+				paragraph += Next(8) == 0 ? ", " : " ";
+			size_t length = 1 + Next(10);
+			for (size_t i = 0; i < length; i++)
+				paragraph += static_cast<char>((i == 0 && Next(4) == 0 ? 'A' : 'a') + Next(26));
+		}
+		paragraph.resize(characters);
+		return paragraph;
+	}
+
+	/**
+	 * \brief Fills a font with 95 glyphs and pairs different kernings between them, the way Fnt::Build does from a file
+	 */
+	void MakeFont(Fnt::Fnt& font, int pairs)
+	{
+		font.ogSize = 24;
+		for (int id = 32; id < 127; id++)
+		{
+			Fnt::FntChar ch;
+			ch.id = id;
+			ch.xAdvance = id == 32 ? 6 : 8 + static_cast<int>(Next(8));
+			ch.dst = { 0, 0, static_cast<float>(ch.xAdvance), 24 };
+			font.chars.push_back(ch);
+		}
+		font.BuildLookup();
+
+		font.hasKernings = true;
+		int kerned = 0;
+		while (kerned < pairs)
+		{
+			Fnt::FntChar* first = font.GetCharPtr(static_cast<char>(33 + Next(94)));
+			Fnt::Kerning k;
+			k.with = 33 + static_cast<int>(Next(94));
+			k.amount = 1 + static_cast<int>(Next(3));
+			// the first pair wins, like the scan did
+			if (font.kerningPairs.emplace(Fnt::Fnt::KerningKey(first->id, k.with), k.amount).second)
+			{
+				first->kernings.push_back(k);
+				kerned++;
+			}
+		}
+	}
+
+	/**
+	 * \brief Fills a font from a .fnt's data (the same as Fnt::Build, but without its texture)
+	 */
+	bool LoadFont(Fnt::Fnt& font, const std::string& folder, const std::string& file)
+	{
+		Fnt::FntData data;
+		std::vector<std::string> log;
+		Fnt::Fnt::useCache = false;
+		if (!Fnt::Fnt::Load(folder, file, data, log))
+		{
+			for (const std::string& line : log)
+				std::cout << "[GlyphLookupBenchmark] " << line << std::endl;
+			return false;
+		}
+
+		font.ogSize = data.ogSize;
+		for (const Fnt::FntCacheChar& c : data.chars)
+		{
+			Fnt::FntChar ch;
+			ch.id = c.id;
+			ch.xAdvance = c.xAdvance;
+			ch.dst = { c.x, c.y, c.w, c.h };
+			font.chars.push_back(ch);
+		}
+		std::sort(font.chars.begin(), font.chars.end());
+		font.BuildLookup();
+
+		font.hasKernings = data.hasKernings;
+		for (const Fnt::FntCacheKerning& k : data.kernings)
+		{
+			Fnt::FntChar* first = const_cast<Fnt::FntChar*>(font.FindChar(k.first));
+			if (!first)
+				continue;
+			Fnt::Kerning kerning;
+			kerning.with = k.second;
+			kerning.amount = k.amount;
+			first->kernings.push_back(kerning);
+			font.kerningPairs.emplace(Fnt::Fnt::KerningKey(first->id, kerning.with), kerning.amount);
+		}
+		return true;
+	}
+
+	struct Glyph
+	{
+		float x = 0, y = 0;
+		float advance = 0;
+
+		bool operator==(const Glyph& other) const = default;
+	};
+
+	/**
+	 * \brief Fnt::GetChar before the lookup tables (a linear search that returns a copy)
+	 */
+	Fnt::FntChar OldGetChar(const Fnt::Fnt& font, char c)
+	{
+		unsigned int u = c;
+
+		auto it = std::find_if(font.chars.begin(), font.chars.end(), [&u](const Fnt::FntChar& obj) {return static_cast<unsigned int>(obj.id) == u; });
+
+		if (it != font.chars.end())
+			return *it;
+
+		Fnt::FntChar cc;
+		cc.id = -1;
+
+		return cc;
+	}
+
+	/**
+	 * \brief The glyph pass of Text::Layout, with lookup(font, text, i, fileAdvance, h) finding the character, its kerned advance, and its height
+	 */
+	template <typename Lookup>
+	void Layout(const Fnt::Fnt& font, const std::string& text, float scale, std::vector<Glyph>& out, Lookup lookup)
+	{
+		out.clear();
+		float x = 0, y = 0;
+		float highestH = 0;
+		for (size_t i = 0; i < text.size(); i++)
+		{
+			float fileAdvance = 0;
+			float h = 0;
+			if (!lookup(font, text, i, fileAdvance, h))
+				continue;
+			float advance = fileAdvance * scale;
+			if (text[i] == 32)
+			{
+				x += advance;
+				if (x > wrapWidth)
+				{
+					x = 0;
+					y += highestH;
+					highestH = 0;
+				}
+				continue;
+			}
+			highestH = std::max(highestH, h * scale);
+			out.push_back({ x, y, advance });
+			x += advance;
+		}
+	}
+
+	bool OldLookup(const Fnt::Fnt& font, const std::string& text, size_t i, float& fileAdvance, float& h)
+	{
+		const Fnt::FntChar c = OldGetChar(font, text[i]);
+		if (c.id == -1)
+			return false;
+		fileAdvance = static_cast<float>(c.xAdvance);
+		h = c.dst.h;
+		if (i + 1 < text.size() && font.hasKernings)
+		{
+			// check kerning
+			char next = text[i + 1];
+			for (int j = 0; j < static_cast<int>(c.kernings.size()); j++)
+			{
+				if (c.kernings[j].with == next)
+				{
+					fileAdvance -= c.kernings[j].amount;
+					break;
+				}
+			}
+		}
+		return true;
+	}
+
+	bool TableLookup(const Fnt::Fnt& font, const std::string& text, size_t i, float& fileAdvance, float& h)
+	{
+		const Fnt::FntChar& c = font.GetChar(text[i]);
+		if (c.id == -1)
+			return false;
+		fileAdvance = static_cast<float>(c.xAdvance);
+		h = c.dst.h;
+		if (i + 1 < text.size() && font.hasKernings)
+			fileAdvance -= font.GetKerning(c.id, static_cast<unsigned char>(text[i + 1]));
+		return true;
+	}
+
+	template <typename Lookup>
+	double Run(const Fnt::Fnt& font, const std::string& text, int iterations, std::vector<Glyph>& out, Lookup lookup)
+	{
+		// warm up
+		Layout(font, text, 1.5f, out, lookup);
+
+		double start = Now();
+		for (int i = 0; i < iterations; i++)
+			Layout(font, text, 1.5f, out, lookup);
+		return (Now() - start) / iterations;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	size_t characters = argc > 1 ? std::strtoull(argv[1], NULL, 10) : 10000;
+	int iterations = argc > 2 ? std::atoi(argv[2]) : 100;
+	if (characters == 0 || iterations <= 0)
+	{
+		std::cout << "[GlyphLookupBenchmark] [Error] Need at least one character and one iteration" << std::endl;
+		return 1;
+	}
+
+	Fnt::Fnt font;
+	if (argc > 4)
+	{
+		if (!LoadFont(font, argv[3], argv[4]))
+		{
+			std::cout << "[GlyphLookupBenchmark] [Error] Couldn't load " << argv[3] << "/" << argv[4] << std::endl;
+			return 1;
+		}
+	}
+	else
+		MakeFont(font, 3000);
+
+	size_t kernings = 0;
+	for (const Fnt::FntChar& c : font.chars)
+		kernings += c.kernings.size();
+
+	std::string text = MakeParagraph(characters);
+
+	std::vector<Glyph> oldGlyphs;
+	std::vector<Glyph> tableGlyphs;
+	double oldMs = Run(font, text, iterations, oldGlyphs, OldLookup);
+	double tableMs = Run(font, text, iterations, tableGlyphs, TableLookup);
+
+	std::cout << std::fixed << std::setprecision(4);
+	std::cout << "[GlyphLookupBenchmark] " << characters << " characters, " << font.chars.size() << " glyphs in the font, "
+		<< kernings << " kernings, " << iterations << " iterations" << std::endl;
+	std::cout << "[GlyphLookupBenchmark] Linear scans:  " << oldMs << "ms per layout" << std::endl;
+	std::cout << "[GlyphLookupBenchmark] Lookup tables: " << tableMs << "ms per layout" << std::endl;
+	std::cout << "[GlyphLookupBenchmark] The tables are " << std::setprecision(2) << oldMs / tableMs << "x faster" << std::endl;
+
+	if (oldGlyphs != tableGlyphs)
+	{
+		size_t i = 0;
+		while (i < std::min(oldGlyphs.size(), tableGlyphs.size()) && oldGlyphs[i] == tableGlyphs[i])
+			i++;
+		std::cout << "[GlyphLookupBenchmark] [Error] The layouts differ, starting at glyph " << i << " of " << oldGlyphs.size() << std::endl;
+		return 1;
+	}
+	std::cout << "[GlyphLookupBenchmark] Both laid out " << tableGlyphs.size() << " glyphs with the same advances" << std::endl;
+	return 0;
+}
@@ -0,0 +1,184 @@
+/*
+	Copyright 2021-2023 AvgEngine - Kade
+
+	Use of this source code without explict permission from owner is strictly prohibited.
+*/
+
+/*
+	Compares drawing sprites as batched quads against drawing them as GPU instances.
+
+	InstancingBenchmark [frames] [counts...]
+
+	For every count (10000, 50000 and 100000 by default) a scene of that many sprites (some rotated, some scaled around their
+	center) is drawn through a Camera, once with quads built on the CPU and once with Camera::instancedSprites. Each path
+	reports the CPU time spent submitting the sprites, the time for the whole frame (submitting, drawing, and waiting for the
+	GPU), and how many bytes were uploaded.
+*/
+
+#include <Glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <AvgEngine/Base/Sprite.h>
+#include <AvgEngine/Render/Display.h>
+#include <AvgEngine/Render/OpenGL/Extensions.h>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+using namespace AvgEngine;
+
+namespace
+{
+	const int frameW = 1920;
+	const int frameH = 1080;
+
+	double Now()
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	struct Result
+	{
+		double submitMs = 0;
+		double frameMs = 0;
+		size_t bytes = 0;
+		int drawCalls = 0;
+	};
+
+	/**
+	 * \brief A root object holding count sprites spread over the frame (all on screen, so none get culled)
+	 */
+	Base::GameObject* MakeScene(Base::Camera* camera, OpenGL::Texture* texture, int count)
+	{
+		Base::GameObject* root = new Base::GameObject(Render::Rect(0, 0, frameW, frameH));
+		root->camera = camera;
+		uint32_t seed = 1234567;
+		auto next = [&]() {
+			seed = seed * 1664525 + 1013904223;
+			return (seed >> 8) / static_cast<float>(1 << 24);
+		};
+		for (int i = 0; i < count; i++)
+		{
+			Base::Sprite* sprite = new Base::Sprite(next() * (frameW - 32), next() * (frameH - 32), texture);
+			sprite->transform.w = 32;
+			sprite->transform.h = 32;
+			if (i % 4 == 0)
+				sprite->transform.angle = next() * 360;
+			if (i % 7 == 0)
+			{
+				sprite->center = true;
+				sprite->transform.scale = 0.5f + next();
+			}
+			root->addObject(sprite);
+		}
+		return root;
+	}
+
+	Result Run(Base::Camera* camera, Base::GameObject* scene, bool instanced, int frames)
+	{
+		camera->instancedSprites = instanced;
+
+		// warm up (buckets and buffers get sized on the first frames)
+		for (int i = 0; i < 3; i++)
+		{
+			scene->draw();
+			camera->draw();
+		}
+		glFinish();
+
+		Result result;
+		double start = Now();
+		for (int i = 0; i < frames; i++)
+		{
+			double submit = Now();
+			scene->draw();
+			result.submitMs += Now() - submit;
+			camera->draw();
+		}
+		glFinish();
+		result.frameMs = (Now() - start) / frames;
+		result.submitMs /= frames;
+		result.bytes = camera->stats.bytes;
+		result.drawCalls = camera->stats.drawCalls;
+		return result;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	int frames = argc > 1 ? std::atoi(argv[1]) : 20;
+	std::vector<int> counts;
+	for (int i = 2; i < argc; i++)
+		counts.push_back(std::atoi(argv[i]));
+	if (counts.size() == 0)
+		counts = { 10000, 50000, 100000 };
+
+	if (!glfwInit())
+	{
+		std::cout << "[InstancingBenchmark] [Error] Failed to start GLFW" << std::endl;
+		return 1;
+	}
+	glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+	GLFWwindow* window = glfwCreateWindow(frameW, frameH, "InstancingBenchmark", NULL, NULL);
+	if (!window)
+	{
+		std::cout << "[InstancingBenchmark] [Error] Failed to create a window" << std::endl;
+		glfwTerminate();
+		return 1;
+	}
+	glfwMakeContextCurrent(window);
+	gladLoadGLLoader(reinterpret_cast<GLADloadproc>(glfwGetProcAddress));
+
+	Render::Display::width = frameW;
+	Render::Display::height = frameH;
+	Render::Display::Init();
+	std::cout << "[InstancingBenchmark] " << glGetString(GL_RENDERER) << ", GL " << OpenGL::Extensions::major << "." << OpenGL::Extensions::minor << std::endl;
+	if (Render::Display::instancedShader == NULL)
+	{
+		std::cout << "[InstancingBenchmark] [Error] Instancing isn't supported here" << std::endl;
+		glfwDestroyWindow(window);
+		glfwTerminate();
+		return 1;
+	}
+
+	// drawn offscreen so the window (and vsync) don't matter
+	GLuint target = 0;
+	GLuint fbo = 0;
+	glGenTextures(1, &target);
+	glBindTexture(GL_TEXTURE_2D, target);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, frameW, frameH, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+	glGenFramebuffers(1, &fbo);
+	glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, target, 0);
+	OpenGL::StateCache::Invalidate();
+
+	std::vector<unsigned char> pixels(32 * 32 * 4, 255);
+	OpenGL::Texture* texture = OpenGL::Texture::loadTextureFromData(pixels.data(), 32, 32);
+
+	Base::Camera camera(frameW, frameH);
+	Render::Display::SetProject(camera.projection);
+
+	std::cout << std::fixed << std::setprecision(2);
+	for (int count : counts)
+	{
+		Base::GameObject* scene = MakeScene(&camera, texture, count);
+		Result batched = Run(&camera, scene, false, frames);
+		Result instanced = Run(&camera, scene, true, frames);
+		delete scene;
+
+		std::cout << "[InstancingBenchmark] " << count << " sprites" << std::endl;
+		std::cout << "  batched:   submit " << batched.submitMs << "ms, frame " << batched.frameMs << "ms, "
+			<< batched.bytes / 1024 << "KB uploaded, " << batched.drawCalls << " draws" << std::endl;
+		std::cout << "  instanced: submit " << instanced.submitMs << "ms, frame " << instanced.frameMs << "ms, "
+			<< instanced.bytes / 1024 << "KB uploaded, " << instanced.drawCalls << " draws" << std::endl;
+	}
+
+	delete texture;
+	glfwDestroyWindow(window);
+	glfwTerminate();
+	return 0;
+}
@@ -0,0 +1,285 @@
+/*
+	Copyright 2021-2023 AvgEngine - Kade
+
+	Use of this source code without explict permission from owner is strictly prohibited.
+*/
+
+/*
+	Measures what mips do for sprites that are drawn scaled down.
+
+	MipmapBenchmark [scale] [layers] [texture size]
+
+	A noisy texture (2048x2048 by default) is drawn as a grid of sprites at 0.25x, layered over itself so texture fetches are
+	most of the frame, into a 1920x1080 framebuffer. Each mip mode reports how long the mips took to make, how much VRAM the
+	texture takes up, the frame time, and the shimmer (how much the frame changes when every sprite moves half a pixel, which
+	is the aliasing you see as sprites move).
+*/
+
+#include <Glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <AvgEngine/Render/Mipmaps.h>
+#include <AvgEngine/Render/OpenGL/Extensions.h>
+#include <AvgEngine/Render/OpenGL/Texture.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace AvgEngine;
+
+namespace
+{
+	const int frameW = 1920;
+	const int frameH = 1080;
+
+	const char* vertexSource = R"(#version 150 core
+in vec2 a_position;
+in vec2 a_uv;
+out vec2 v_uv;
+uniform vec2 u_size;
+uniform vec2 u_offset;
+void main()
+{
+	v_uv = a_uv;
+	vec2 p = (a_position + u_offset) / u_size * 2.0 - 1.0;
+	gl_Position = vec4(p, 0.0, 1.0);
+}
+)";
+
+	const char* fragmentSource = R"(#version 150 core
+in vec2 v_uv;
+out vec4 FragColor;
+uniform sampler2D u_texture;
+void main()
+{
+	FragColor = texture(u_texture, v_uv);
+}
+)";
+
+	double Now()
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	GLuint Compile(GLenum type, const char* source)
+	{
+		GLuint shader = glCreateShader(type);
+		glShaderSource(shader, 1, &source, NULL);
+		glCompileShader(shader);
+		GLint ok = 0;
+		glGetShaderiv(shader, GL_COMPILE_STATUS, &ok);
+		if (!ok)
+		{
+			char log[1024];
+			glGetShaderInfoLog(shader, sizeof(log), NULL, log);
+			std::cout << "[MipmapBenchmark] [Error] " << log << std::endl;
+		}
+		return shader;
+	}
+
+	/**
+	 * \brief Value noise with a fine grain on top, so there's plenty of detail for minification to alias on
+	 */
+	std::vector<unsigned char> MakeImage(int size)
+	{
+		std::vector<unsigned char> pixels(static_cast<size_t>(size) * size * 4);
+		uint32_t seed = 1234567;
+		for (size_t i = 0; i < pixels.size(); i += 4)
+		{
+			size_t p = i / 4;
+			int x = static_cast<int>(p % size);
+			int y = static_cast<int>(p / size);
+			seed = seed * 1664525 + 1013904223;
+			int grain = (seed >> 24) & 0x3f;
+			bool checker = ((x / 4) + (y / 4)) % 2 == 0;
+			pixels[i] = static_cast<unsigned char>((checker ? 180 : 40) + grain);
+			pixels[i + 1] = static_cast<unsigned char>(((x * 255) / size + grain) & 0xff);
+			pixels[i + 2] = static_cast<unsigned char>(((y * 255) / size + grain) & 0xff);
+			pixels[i + 3] = 255;
+		}
+		return pixels;
+	}
+
+	struct Result
+	{
+		double buildMs = 0;
+		size_t gpuBytes = 0;
+		double frameMs = 0;
+		double shimmer = 0;
+	};
+}
+
+int main(int argc, char** argv)
+{
+	float scale = argc > 1 ? static_cast<float>(std::atof(argv[1])) : 0.25f;
+	int layers = argc > 2 ? std::atoi(argv[2]) : 8;
+	int size = argc > 3 ? std::atoi(argv[3]) : 2048;
+	const int frames = 30;
+
+	if (!glfwInit())
+	{
+		std::cout << "[MipmapBenchmark] [Error] Failed to start GLFW" << std::endl;
+		return 1;
+	}
+	glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+	GLFWwindow* window = glfwCreateWindow(64, 64, "MipmapBenchmark", NULL, NULL);
+	if (!window)
+	{
+		std::cout << "[MipmapBenchmark] [Error] Failed to create a window" << std::endl;
+		glfwTerminate();
+		return 1;
+	}
+	glfwMakeContextCurrent(window);
+	gladLoadGLLoader(reinterpret_cast<GLADloadproc>(glfwGetProcAddress));
+	OpenGL::Extensions::Load();
+	std::cout << "[MipmapBenchmark] " << glGetString(GL_RENDERER) << ", GL " << OpenGL::Extensions::major << "." << OpenGL::Extensions::minor << std::endl;
+
+	// drawn offscreen so the window size (and vsync) don't matter
+	GLuint target = 0;
+	GLuint fbo = 0;
+	glGenTextures(1, &target);
+	glBindTexture(GL_TEXTURE_2D, target);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, frameW, frameH, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+	glGenFramebuffers(1, &fbo);
+	glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, target, 0);
+	glViewport(0, 0, frameW, frameH);
+
+	GLuint program = glCreateProgram();
+	glAttachShader(program, Compile(GL_VERTEX_SHADER, vertexSource));
+	glAttachShader(program, Compile(GL_FRAGMENT_SHADER, fragmentSource));
+	glBindAttribLocation(program, 0, "a_position");
+	glBindAttribLocation(program, 1, "a_uv");
+	glLinkProgram(program);
+	glUseProgram(program);
+	glUniform2f(glGetUniformLocation(program, "u_size"), static_cast<float>(frameW), static_cast<float>(frameH));
+	glUniform1i(glGetUniformLocation(program, "u_texture"), 0);
+	GLint offset = glGetUniformLocation(program, "u_offset");
+
+	// a grid of sprites covering the frame, repeated for every layer (every layer is shifted a bit so they don't line up)
+	std::vector<float> vertices;
+	float sprite = size * scale;
+	for (int l = 0; l < layers; l++)
+	{
+		float shift = l * 37.0f;
+		for (float y = -sprite + std::fmod(shift, sprite); y < frameH; y += sprite)
+		{
+			for (float x = -sprite + std::fmod(shift * 1.7f, sprite); x < frameW; x += sprite)
+			{
+				float quad[] = {
+					x, y, 0, 0,
+					x + sprite, y, 1, 0,
+					x, y + sprite, 0, 1,
+					x + sprite, y, 1, 0,
+					x + sprite, y + sprite, 1, 1,
+					x, y + sprite, 0, 1,
+				};
+				vertices.insert(vertices.end(), quad, quad + 24);
+			}
+		}
+	}
+	GLsizei vertexCount = static_cast<GLsizei>(vertices.size() / 4);
+
+	GLuint vao = 0;
+	GLuint vbo = 0;
+	glGenVertexArrays(1, &vao);
+	glBindVertexArray(vao);
+	glGenBuffers(1, &vbo);
+	glBindBuffer(GL_ARRAY_BUFFER, vbo);
+	glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), reinterpret_cast<void*>(0));
+	glEnableVertexAttribArray(1);
+	glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), reinterpret_cast<void*>(2 * sizeof(float)));
+
+	std::vector<unsigned char> image = MakeImage(size);
+	std::cout << "[MipmapBenchmark] " << size << "x" << size << " texture at " << scale << "x, " << layers << " layers ("
+		<< vertexCount / 6 << " sprites, " << frames << " frames)" << std::endl;
+
+	auto draw = [&](float dx) {
+		glUniform2f(offset, dx, 0);
+		glClear(GL_COLOR_BUFFER_BIT);
+		glDrawArrays(GL_TRIANGLES, 0, vertexCount);
+	};
+
+	auto readBack = [&]() {
+		std::vector<unsigned char> pixels(static_cast<size_t>(frameW) * frameH * 4);
+		glReadPixels(0, 0, frameW, frameH, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+		return pixels;
+	};
+
+	const Render::MipMode modes[] = { Render::MipMode::None, Render::MipMode::Hardware, Render::MipMode::Box, Render::MipMode::Kaiser };
+	const char* names[] = { "None", "Hardware", "Box", "Kaiser" };
+	Result results[4];
+
+	for (int m = 0; m < 4; m++)
+	{
+		Render::MipMode mode = modes[m];
+		Result& result = results[m];
+
+		OpenGL::Texture::defaultMipMode = Render::MipMode::None;
+		OpenGL::Texture* texture = OpenGL::Texture::loadTextureFromData(image.data(), size, size);
+		glFinish();
+
+		double start = Now();
+		if (mode == Render::MipMode::Box || mode == Render::MipMode::Kaiser)
+			texture->SetMips(Render::Mipmaps::Chain(mode, image.data(), size, size), mode);
+		else
+			texture->BuildMips(mode);
+		glFinish();
+		result.buildMs = Now() - start;
+		result.gpuBytes = texture->gpuBytes;
+
+		glActiveTexture(GL_TEXTURE0);
+		texture->Bind();
+		glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+
+		// warm up
+		for (int i = 0; i < 3; i++)
+			draw(0);
+		glFinish();
+
+		start = Now();
+		for (int i = 0; i < frames; i++)
+			draw(0);
+		glFinish();
+		result.frameMs = (Now() - start) / frames;
+
+		draw(0);
+		std::vector<unsigned char> a = readBack();
+		draw(0.5f);
+		std::vector<unsigned char> b = readBack();
+		double difference = 0;
+		for (size_t i = 0; i < a.size(); i += 4)
+			for (int c = 0; c < 3; c++)
+				difference += std::abs(a[i + c] - b[i + c]);
+		result.shimmer = difference / (static_cast<double>(frameW) * frameH * 3);
+
+		delete texture;
+	}
+
+	std::cout << std::left << std::setw(10) << "mips" << std::setw(12) << "build ms" << std::setw(10) << "VRAM MB"
+		<< std::setw(12) << "frame ms" << std::setw(10) << "speedup" << "shimmer" << std::endl;
+	for (int m = 0; m < 4; m++)
+	{
+		const Result& result = results[m];
+		std::cout << std::left << std::fixed << std::setprecision(2) << std::setw(10) << names[m] << std::setw(12) << result.buildMs
+			<< std::setw(10) << result.gpuBytes / (1024.0 * 1024.0) << std::setw(12) << result.frameMs
+			<< std::setw(10) << results[0].frameMs / result.frameMs << result.shimmer << std::endl;
+	}
+
+	glDeleteBuffers(1, &vbo);
+	glDeleteVertexArrays(1, &vao);
+	glDeleteProgram(program);
+	glDeleteFramebuffers(1, &fbo);
+	glDeleteTextures(1, &target);
+	glfwDestroyWindow(window);
+	glfwTerminate();
+	return 0;
+}
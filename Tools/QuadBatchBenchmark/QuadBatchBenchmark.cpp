@@ -0,0 +1,148 @@
+/*
+	Copyright 2021-2023 AvgEngine - Kade
+
+	Use of this source code without explict permission from owner is strictly prohibited.
+*/
+
+/*
+	Times QuadBatch::Expand (SSE2) against QuadBatch::ExpandScalar, and checks both against DisplayHelper::RectToQuad.
+
+	QuadBatchBenchmark [quads] [iterations]
+
+	A batch of quads (100000 by default, a mix of plain, rotated and center scaled ones) is expanded to vertices over and over
+	by both paths. Each path reports how long an expand took and how far its vertices are from what RectToQuad gives for the
+	same quads. The tool fails if either is further off than the tolerance, so it can be used to check Expand after changing it.
+*/
+
+#include <AvgEngine/Render/QuadBatch.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+using namespace AvgEngine;
+
+namespace
+{
+	// positions are in pixels, so this is well under what can be seen. rotation goes through sin/cos in a different order on
+	// each path, so they can't be expected to match exactly
+	const float positionTolerance = 0.01f;
+	const float uvTolerance = 0.0001f;
+	// each channel is rounded to 8 bits, so allow one step
+	const int colourTolerance = 1;
+
+	double Now()
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	struct Deviation
+	{
+		float position = 0;
+		float uv = 0;
+		int colour = 0;
+
+		bool within() const
+		{
+			return position <= positionTolerance && uv <= uvTolerance && colour <= colourTolerance;
+		}
+	};
+
+	Deviation Compare(const std::vector<Render::Vertex>& got, const std::vector<Render::Vertex>& expected)
+	{
+		Deviation d;
+		for (size_t i = 0; i < got.size(); i++)
+		{
+			d.position = std::max({ d.position, std::abs(got[i].x - expected[i].x), std::abs(got[i].y - expected[i].y) });
+			d.uv = std::max({ d.uv, std::abs(got[i].u - expected[i].u), std::abs(got[i].v - expected[i].v) });
+			for (int c = 0; c < 32; c += 8)
+			{
+				int a = (got[i].colour >> c) & 0xFF;
+				int b = (expected[i].colour >> c) & 0xFF;
+				d.colour = std::max(d.colour, std::abs(a - b));
+			}
+		}
+		return d;
+	}
+
+	void Report(const char* name, double ms, size_t quads, const Deviation& d)
+	{
+		std::cout << "[QuadBatchBenchmark] " << name << ": " << ms << "ms per expand (" << (quads / ms) / 1000.0 << "M quads/s), "
+			<< "max deviation " << d.position << "px, " << d.uv << " uv, " << d.colour << " colour" << std::endl;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	size_t quads = argc > 1 ? std::strtoull(argv[1], NULL, 10) : 100000;
+	int iterations = argc > 2 ? std::atoi(argv[2]) : 50;
+	if (quads == 0 || iterations <= 0)
+	{
+		std::cout << "[QuadBatchBenchmark] [Error] Need at least one quad and one iteration" << std::endl;
+		return 1;
+	}
+
+	Render::QuadBatch batch;
+	batch.reserve(quads);
+	std::vector<Render::Vertex> expected(quads * 4);
+	uint32_t seed = 1234567;
+	auto next = [&]() {
+		seed = seed * 1664525 + 1013904223;
+		return (seed >> 8) / static_cast<float>(1 << 24);
+	};
+	for (size_t i = 0; i < quads; i++)
+	{
+		Render::Rect dst(next() * 1920, next() * 1080, 8 + next() * 120, 8 + next() * 120);
+		dst.r = next() * 255;
+		dst.g = next() * 255;
+		dst.b = next() * 255;
+		dst.a = next();
+		if (i % 3 == 0)
+			dst.angle = next() * 360;
+		bool center = i % 5 == 0;
+		if (center || i % 4 == 0)
+			dst.scale = 0.25f + next() * 2;
+		Render::Rect src(next() * 0.5f, next() * 0.5f, next() * 0.5f, next() * 0.5f);
+		batch.push(dst, src, center);
+		Render::DisplayHelper::RectToQuad(std::span<Render::Vertex, 4>(expected.data() + i * 4, 4), dst, src, center);
+	}
+
+	std::vector<Render::Vertex> simd(quads * 4);
+	std::vector<Render::Vertex> scalar(quads * 4);
+
+	// warm up (faults the output pages in so the first timed path isn't charged for it)
+	batch.Expand(simd);
+	batch.ExpandScalar(scalar);
+
+	double start = Now();
+	for (int i = 0; i < iterations; i++)
+		batch.Expand(simd);
+	double simdMs = (Now() - start) / iterations;
+
+	start = Now();
+	for (int i = 0; i < iterations; i++)
+		batch.ExpandScalar(scalar);
+	double scalarMs = (Now() - start) / iterations;
+
+	Deviation simdDeviation = Compare(simd, expected);
+	Deviation scalarDeviation = Compare(scalar, expected);
+
+	std::cout << std::fixed << std::setprecision(4);
+	std::cout << "[QuadBatchBenchmark] " << quads << " quads, " << iterations << " iterations" << std::endl;
+	Report("Expand", simdMs, quads, simdDeviation);
+	Report("ExpandScalar", scalarMs, quads, scalarDeviation);
+	std::cout << "[QuadBatchBenchmark] Expand is " << std::setprecision(2) << scalarMs / simdMs << "x ExpandScalar" << std::endl;
+
+	if (!simdDeviation.within() || !scalarDeviation.within())
+	{
+		std::cout << "[QuadBatchBenchmark] [Error] Expanded vertices are further from RectToQuad than the tolerance ("
+			<< positionTolerance << "px, " << uvTolerance << " uv, " << colourTolerance << " colour)" << std::endl;
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,145 @@
+/*
+	Copyright 2021-2023 AvgEngine - Kade
+
+	Use of this source code without explict permission from owner is strictly prohibited.
+*/
+
+/*
+	Measures how long compiling shaders at startup takes with and without the program cache.
+
+	ShaderCacheBenchmark [shaders] [clear|off]
+
+	Compiles the engine's default shaders plus a set of generated sprite effect shaders (24 by default), the way a game does
+	when it starts. "clear" empties the cache first (a first launch), "off" doesn't use it at all. Run it once with clear and
+	then again without to see a cold and a warm start. The driver might have a shader cache of its own, turn it off for a fair
+	baseline (MESA_SHADER_CACHE_DISABLE=true on Mesa).
+*/
+
+#include <Glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <AvgEngine/Render/OpenGL/Extensions.h>
+#include <AvgEngine/Render/OpenGL/ProgramCache.h>
+#include <AvgEngine/Render/OpenGL/Shader.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace AvgEngine;
+
+namespace
+{
+	/**
+	 * \brief A sprite effect that's different for every index (so none of them share a cache entry)
+	 */
+	std::string MakeEffect(int index)
+	{
+		int octaves = 4 + index % 5;
+		std::string a = std::to_string(1.5f + index * 0.37f);
+		std::string b = std::to_string(2.0f + index * 0.11f);
+		return R"(
+		uniform sampler2D u_texture;
+		uniform float u_strength;
+		in vec2 f_uv;
+		in vec4 f_colour;
+		out vec4 o_colour;
+
+		float wave(vec2 p)
+		{
+			float v = 0.0;
+			float amplitude = 0.5;
+			for (int i = 0; i < )" + std::to_string(octaves) + R"(; i++)
+			{
+				v += amplitude * sin(p.x * float(i + 1) * )" + a + R"( + iTime) * cos(p.y * float(i + 1) * )" + b + R"();
+				amplitude *= 0.5;
+			}
+			return v;
+		}
+
+		void main()
+		{
+			vec2 offset = vec2(wave(f_uv), wave(f_uv.yx)) * u_strength;
+			vec4 c = texture(u_texture, f_uv + offset) * f_colour;
+			float grey = dot(c.rgb, vec3(0.299, 0.587, 0.114));
+			c.rgb = mix(c.rgb, vec3(grey), clamp(wave(f_uv * 3.0) + 0.5, 0.0, 1.0) * )" + std::to_string((index % 7) / 7.0f) + R"();
+			o_colour = c;
+			if (o_colour.a == 0.0)
+				discard;
+		})";
+	}
+}
+
+int main(int argc, char** argv)
+{
+	int count = argc > 1 ? std::atoi(argv[1]) : 24;
+	std::string mode = argc > 2 ? argv[2] : "";
+
+	if (!glfwInit())
+	{
+		std::cout << "[ShaderCacheBenchmark] [Error] Failed to start GLFW" << std::endl;
+		return 1;
+	}
+	glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+	GLFWwindow* window = glfwCreateWindow(64, 64, "ShaderCacheBenchmark", NULL, NULL);
+	if (!window)
+	{
+		std::cout << "[ShaderCacheBenchmark] [Error] Failed to create a window" << std::endl;
+		glfwTerminate();
+		return 1;
+	}
+	glfwMakeContextCurrent(window);
+	gladLoadGLLoader(reinterpret_cast<GLADloadproc>(glfwGetProcAddress));
+	OpenGL::Extensions::Load();
+	std::cout << "[ShaderCacheBenchmark] " << glGetString(GL_RENDERER) << ", GL " << OpenGL::Extensions::major << "." << OpenGL::Extensions::minor
+		<< (OpenGL::Extensions::programBinary != NULL ? ", program binaries supported" : ", program binaries not supported") << std::endl;
+
+	OpenGL::ProgramCache::enabled = mode != "off";
+	if (mode == "clear")
+		OpenGL::ProgramCache::Clear();
+
+	std::vector<std::string> effects;
+	for (int i = 0; i < count; i++)
+		effects.push_back(MakeEffect(i));
+
+	auto start = std::chrono::steady_clock::now();
+
+	std::vector<OpenGL::Shader*> shaders;
+	shaders.push_back(new OpenGL::Shader());
+	shaders.back()->GL_CompileShader(NULL, NULL);
+	shaders.push_back(new OpenGL::Shader());
+	shaders.back()->GL_CompileShader(OpenGL::instanced_shader_vert, NULL);
+	shaders.push_back(new OpenGL::Shader());
+	shaders.back()->GL_CompileShader(NULL, OpenGL::sdf_shader_frag);
+	for (const std::string& effect : effects)
+	{
+		shaders.push_back(new OpenGL::Shader());
+		shaders.back()->GL_CompileShader(NULL, effect.c_str());
+	}
+	// drivers can link lazily, using every program makes sure they're really ready
+	for (OpenGL::Shader* shader : shaders)
+		shader->GL_Use();
+	glFinish();
+
+	float ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+	int linked = 0;
+	for (OpenGL::Shader* shader : shaders)
+	{
+		GLint status = GL_FALSE;
+		glGetProgramiv(shader->program, GL_LINK_STATUS, &status);
+		if (status == GL_TRUE)
+			linked++;
+		delete shader;
+	}
+
+	std::cout << "[ShaderCacheBenchmark] " << shaders.size() << " programs (" << linked << " linked) in " << ms << "ms, "
+		<< OpenGL::ProgramCache::hits << " cache hits, " << OpenGL::ProgramCache::misses << " misses"
+		<< (mode == "off" ? " (cache off)" : "") << std::endl;
+
+	glfwDestroyWindow(window);
+	glfwTerminate();
+	return linked == static_cast<int>(shaders.size()) ? 0 : 1;
+}
@@ -0,0 +1,160 @@
+/*
+	Copyright 2021-2023 AvgEngine - Kade
+
+	Use of this source code without explict permission from owner is strictly prohibited.
+*/
+
+/*
+	Measures what keeping a Text's layout between draws saves.
+
+	TextLayoutBenchmark <font folder> <font file> [characters] [iterations]
+
+	A paragraph of words (10000 characters by default) is wrapped inside a 1600 pixel wide box and drawn with the given font,
+	once laying it out again every draw (as Text did before the layout was cached) and once reusing the layout. Each reports
+	how long a Text::draw took, which is the layout (when it's redone) plus putting the visible glyphs into the camera.
+*/
+
+#include <Glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <AvgEngine/Base/Text.h>
+#include <AvgEngine/Render/Display.h>
+#include <AvgEngine/Render/OpenGL/Extensions.h>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+using namespace AvgEngine;
+
+namespace
+{
+	const int frameW = 1920;
+	const int frameH = 1080;
+
+	double Now()
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	/**
+	 * \brief Words of 1 to 10 letters (and some punctuation) until the paragraph is characters long
+	 */
+	std::string MakeParagraph(size_t characters)
+	{
+		std::string paragraph;
+		paragraph.reserve(characters);
+		uint32_t seed = 1234567;
+		auto next = [&](uint32_t range) {
+			seed = seed * 1664525 + 1013904223;
+			return (seed >> 8) % range;
+		};
+		while (paragraph.size() < characters)
+		{
+			if (paragraph.size() != 0)
+				paragraph += next(8) == 0 ? ", " : " ";
+			size_t length = 1 + next(10);
+			for (size_t i = 0; i < length; i++)
+				paragraph += static_cast<char>((i == 0 && next(4) == 0 ? 'A' : 'a') + next(26));
+		}
+		paragraph.resize(characters);
+		return paragraph;
+	}
+
+	/**
+	 * \brief Draws the text iterations times and returns the average ms for Text::draw
+	 */
+	double Run(Base::Camera* camera, Base::Text* text, bool relayout, int iterations)
+	{
+		double total = 0;
+		for (int i = 0; i < iterations; i++)
+		{
+			if (relayout)
+				text->layoutDirty = true;
+			double start = Now();
+			text->draw();
+			total += Now() - start;
+			// flush the glyphs so they don't pile up in the camera
+			camera->draw();
+		}
+		glFinish();
+		return total / iterations;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	if (argc < 3)
+	{
+		std::cout << "[TextLayoutBenchmark] Usage: TextLayoutBenchmark <font folder> <font file> [characters] [iterations]" << std::endl;
+		return 1;
+	}
+	std::string folder = argv[1];
+	std::string font = argv[2];
+	size_t characters = argc > 3 ? std::strtoull(argv[3], NULL, 10) : 10000;
+	int iterations = argc > 4 ? std::atoi(argv[4]) : 100;
+	if (characters == 0 || iterations <= 0)
+	{
+		std::cout << "[TextLayoutBenchmark] [Error] Need at least one character and one iteration" << std::endl;
+		return 1;
+	}
+
+	if (!glfwInit())
+	{
+		std::cout << "[TextLayoutBenchmark] [Error] Failed to start GLFW" << std::endl;
+		return 1;
+	}
+	glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+	GLFWwindow* window = glfwCreateWindow(64, 64, "TextLayoutBenchmark", NULL, NULL);
+	if (!window)
+	{
+		std::cout << "[TextLayoutBenchmark] [Error] Failed to create a window" << std::endl;
+		glfwTerminate();
+		return 1;
+	}
+	glfwMakeContextCurrent(window);
+	gladLoadGLLoader(reinterpret_cast<GLADloadproc>(glfwGetProcAddress));
+
+	Render::Display::width = frameW;
+	Render::Display::height = frameH;
+	Render::Display::Init();
+	Fnt::Fnt::fonts = new std::unordered_map<std::string, Fnt::Fnt*>();
+
+	Base::Camera camera(frameW, frameH);
+	Render::Display::SetProject(camera.projection);
+
+	Base::GameObject* box = new Base::GameObject(Render::Rect(160, 0, 1600, frameH));
+	box->camera = &camera;
+	Base::Text* text = new Base::Text(0, 0, folder, font, MakeParagraph(characters), 24);
+	text->wrap = true;
+	box->addObject(text);
+	if (!text->fnt || text->fnt->texture == NULL)
+	{
+		std::cout << "[TextLayoutBenchmark] [Error] Couldn't load " << folder << "/" << font << std::endl;
+		delete box;
+		glfwDestroyWindow(window);
+		glfwTerminate();
+		return 1;
+	}
+
+	// warm up (the first layout sizes glyphBatch and the camera's buckets)
+	Run(&camera, text, true, 3);
+
+	double uncached = Run(&camera, text, true, iterations);
+	double cached = Run(&camera, text, false, iterations);
+
+	std::cout << std::fixed << std::setprecision(4);
+	std::cout << "[TextLayoutBenchmark] " << characters << " characters, " << text->glyphBatch.size() << " glyphs, "
+		<< text->transform.h << "px tall, " << iterations << " iterations" << std::endl;
+	std::cout << "[TextLayoutBenchmark] Laid out every draw: " << uncached << "ms per draw" << std::endl;
+	std::cout << "[TextLayoutBenchmark] Layout kept:         " << cached << "ms per draw" << std::endl;
+	std::cout << "[TextLayoutBenchmark] Keeping the layout is " << std::setprecision(2) << uncached / cached << "x faster" << std::endl;
+
+	delete box;
+	glfwDestroyWindow(window);
+	glfwTerminate();
+	return 0;
+}
@@ -0,0 +1,139 @@
+/*
+	Copyright 2021-2023 AvgEngine - Kade
+
+	Use of this source code without explict permission from owner is strictly prohibited.
+*/
+
+/*
+	Converts PNG/JPEG images to block compressed .dds files ahead of time, so the game doesn't have to decode them at load.
+
+	TextureTranscoder <image or folder> [output.dds] [bc1|bc3|bc7] [mips]
+
+	Folders convert every .png/.jpg/.jpeg in them, writing each .dds next to the original.
+	Without a format, opaque images become BC1 and anything with alpha becomes BC3.
+	mips stores a full mip chain (made with the Kaiser filter) so scaled down sprites don't alias.
+*/
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+
+#include <AvgEngine/Render/BlockCompression.h>
+#include <AvgEngine/Render/Mipmaps.h>
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <string>
+
+using namespace AvgEngine::Render;
+
+namespace
+{
+	bool IsImage(const std::filesystem::path& path)
+	{
+		std::string extension = path.extension().string();
+		std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+		return extension == ".png" || extension == ".jpg" || extension == ".jpeg";
+	}
+
+	bool Convert(const std::filesystem::path& input, const std::filesystem::path& output, BlockFormat format, bool mips)
+	{
+		auto start = std::chrono::steady_clock::now();
+
+		int w = 0;
+		int h = 0;
+		unsigned char* pixels = stbi_load(input.string().c_str(), &w, &h, nullptr, 4);
+		if (pixels == NULL)
+		{
+			std::cout << "[Transcoder] [Error] Failed to load " << input.string() << ": " << stbi_failure_reason() << std::endl;
+			return false;
+		}
+
+		if (format == BlockFormat::None)
+		{
+			bool opaque = true;
+			for (size_t i = 3; i < static_cast<size_t>(w) * h * 4 && opaque; i += 4)
+				opaque = pixels[i] == 255;
+			format = opaque ? BlockFormat::BC1 : BlockFormat::BC3;
+		}
+
+		CompressedImage image;
+		image.format = format;
+		image.width = w;
+		image.height = h;
+		image.levels.resize(1);
+		BlockCompression::Encode(format, pixels, w, h, image.levels[0]);
+		if (mips)
+		{
+			for (const MipLevel& mip : Mipmaps::Chain(MipMode::Kaiser, pixels, w, h))
+			{
+				image.levels.emplace_back();
+				BlockCompression::Encode(format, mip.data.data(), mip.width, mip.height, image.levels.back());
+			}
+		}
+		stbi_image_free(pixels);
+
+		std::string error;
+		if (!BlockCompression::WriteDDS(output.string(), image, error))
+		{
+			std::cout << "[Transcoder] [Error] Failed to write " << output.string() << ": " << error << std::endl;
+			return false;
+		}
+
+		float ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+		size_t raw = static_cast<size_t>(w) * h * 4;
+		size_t compressed = 0;
+		for (const CompressedLevel& level : image.levels)
+			compressed += level.data.size();
+		std::cout << "[Transcoder] " << input.string() << " -> " << output.string() << " (" << BlockCompression::FormatName(format) << ", "
+			<< w << "x" << h << ", " << image.levels.size() << (image.levels.size() == 1 ? " level, " : " levels, ") << raw / 1024 << "KB -> " << compressed / 1024 << "KB, " << ms << "ms)" << std::endl;
+		return true;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	if (argc < 2)
+	{
+		std::cout << "TextureTranscoder <image or folder> [output.dds] [bc1|bc3|bc7] [mips]" << std::endl;
+		return 1;
+	}
+
+	std::filesystem::path input = argv[1];
+	std::filesystem::path output = "";
+	BlockFormat format = BlockFormat::None;
+	bool mips = false;
+	for (int i = 2; i < argc; i++)
+	{
+		std::string arg = argv[i];
+		if (arg == "bc1")
+			format = BlockFormat::BC1;
+		else if (arg == "bc3")
+			format = BlockFormat::BC3;
+		else if (arg == "bc7")
+			format = BlockFormat::BC7;
+		else if (arg == "mips")
+			mips = true;
+		else
+			output = arg;
+	}
+
+	if (std::filesystem::is_directory(input))
+	{
+		int failed = 0;
+		for (const auto& entry : std::filesystem::recursive_directory_iterator(input))
+		{
+			if (!entry.is_regular_file() || !IsImage(entry.path()))
+				continue;
+			std::filesystem::path dds = entry.path();
+			if (!Convert(entry.path(), dds.replace_extension(".dds"), format, mips))
+				failed++;
+		}
+		return failed == 0 ? 0 : 1;
+	}
+
+	if (output.empty())
+		output = std::filesystem::path(input).replace_extension(".dds");
+	return Convert(input, output, format, mips) ? 0 : 1;
+}